@@ -0,0 +1,148 @@
+#ifndef ASYNC_OPERATION_HPP
+#define ASYNC_OPERATION_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "Scheduler.hpp"
+
+namespace AudioEditor {
+
+/**
+ * Handle to work running on a Scheduler. Completion can be observed with a
+ * callback (onComplete), a blocking get(), or co_await when Coroutines.hpp
+ * is included from a C++20 translation unit.
+ */
+template <typename T>
+class AsyncOperation {
+private:
+    // void results are stored as an empty placeholder
+    struct Empty {};
+    using Stored = typename std::conditional<std::is_void<T>::value, Empty, T>::type;
+
+    struct State {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+        std::optional<Stored> value;
+        std::exception_ptr error;
+        std::function<void()> continuation;
+    };
+
+    std::shared_ptr<State> state;
+
+    template <typename F>
+    static void runInto(State& s, F& fn, std::true_type /*is_void*/) {
+        fn();
+        s.value.emplace();
+    }
+
+    template <typename F>
+    static void runInto(State& s, F& fn, std::false_type /*is_void*/) {
+        s.value.emplace(fn());
+    }
+
+    static void finish(const std::shared_ptr<State>& s) {
+        std::function<void()> next;
+        {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            s->done = true;
+            next = std::move(s->continuation);
+        }
+        s->cv.notify_all();
+        if (next) {
+            next();
+        }
+    }
+
+    explicit AsyncOperation(std::shared_ptr<State> s) : state(std::move(s)) {}
+
+    // Default-constructed and moved-from handles have no state, as with std::future
+    State& checkedState() const {
+        if (!state) {
+            throw std::future_error(std::future_errc::no_state);
+        }
+        return *state;
+    }
+
+public:
+    AsyncOperation() = default;
+
+    /**
+     * Run fn on the scheduler, preferring workers on the given NUMA node.
+     * Exceptions thrown by fn are captured and rethrown from get()/co_await.
+     */
+    template <typename F>
+    static AsyncOperation run(Scheduler& scheduler, F fn, int node = -1) {
+        auto s = std::make_shared<State>();
+        scheduler.submit([s, fn]() mutable {
+            try {
+                runInto(*s, fn, std::is_void<T>());
+            } catch (...) {
+                s->error = std::current_exception();
+            }
+            finish(s);
+        }, node);
+        return AsyncOperation(s);
+    }
+
+    // The accessors below throw std::future_error (no_state) when !valid()
+    bool valid() const { return static_cast<bool>(state); }
+
+    bool ready() const {
+        State& s = checkedState();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        return s.done;
+    }
+
+    /**
+     * Register a callback to run on the completing worker. Returns false and
+     * does not store the callback if the operation has already completed.
+     */
+    bool tryOnComplete(std::function<void()> callback) {
+        State& s = checkedState();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (s.done) {
+            return false;
+        }
+        s.continuation = std::move(callback);
+        return true;
+    }
+
+    // Register a callback, running it inline if the operation already completed
+    void onComplete(std::function<void()> callback) {
+        if (!tryOnComplete(callback)) {
+            callback();
+        }
+    }
+
+    void wait() const {
+        State& s = checkedState();
+        std::unique_lock<std::mutex> lock(s.mutex);
+        s.cv.wait(lock, [&s] { return s.done; });
+    }
+
+    // Block until complete, then return the result or rethrow the failure
+    T get() {
+        wait();
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+        return take(std::is_void<T>());
+    }
+
+private:
+    void take(std::true_type) {}
+    Stored take(std::false_type) { return std::move(*state->value); }
+};
+
+}  // namespace AudioEditor
+
+#endif  // ASYNC_OPERATION_HPP
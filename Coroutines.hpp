@@ -0,0 +1,49 @@
+#ifndef COROUTINES_HPP
+#define COROUTINES_HPP
+
+/**
+ * C++20 coroutine support for AsyncOperation. Include this header from a
+ * C++20 translation unit to write:
+ *
+ *     co_await track.loadAsync("input.wav");
+ *     std::string hits = co_await track.identifyAsync(ad);
+ *
+ * The awaiting coroutine is resumed on the scheduler worker that finished
+ * the operation. The library itself does not require C++20.
+ */
+
+#include "AsyncOperation.hpp"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+
+namespace AudioEditor {
+
+template <typename T>
+class AsyncAwaiter {
+private:
+    AsyncOperation<T> operation;
+
+public:
+    explicit AsyncAwaiter(AsyncOperation<T> op) : operation(std::move(op)) {}
+
+    bool await_ready() const { return operation.ready(); }
+
+    // Returning false resumes immediately if the work finished in the meantime
+    bool await_suspend(std::coroutine_handle<> handle) {
+        return operation.tryOnComplete([handle]() { handle.resume(); });
+    }
+
+    T await_resume() { return operation.get(); }
+};
+
+template <typename T>
+AsyncAwaiter<T> operator co_await(AsyncOperation<T> operation) {
+    return AsyncAwaiter<T>(std::move(operation));
+}
+
+}  // namespace AudioEditor
+
+#endif  // __cpp_impl_coroutine
+
+#endif  // COROUTINES_HPP
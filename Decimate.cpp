@@ -0,0 +1,168 @@
+#include "Decimate.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace AudioEditor {
+
+namespace {
+
+// Sum of count samples
+int64_t sumSamples(const int16_t* samples, size_t count) {
+    int64_t total = 0;
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i ones = _mm_set1_epi16(1);
+    while (count - i >= 8) {
+        // Each 32-bit lane gains at most 2 * 32768 per step; flush well before overflow
+        size_t steps = std::min<size_t>((count - i) / 8, 16384);
+        __m128i acc = _mm_setzero_si128();
+        for (size_t s = 0; s < steps; ++s, i += 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(v, ones));
+        }
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        total += static_cast<int64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    }
+#endif
+    for (; i < count; ++i) {
+        total += samples[i];
+    }
+    return total;
+}
+
+// Fold count samples (count > 0) into low and high
+void minMaxSamples(const int16_t* samples, size_t count, int16_t& low, int16_t& high) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    if (count >= 8) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples));
+        __m128i hi = lo;
+        for (i = 8; count - i >= 8; i += 8) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+            lo = _mm_min_epi16(lo, v);
+            hi = _mm_max_epi16(hi, v);
+        }
+        alignas(16) int16_t lo_lanes[8];
+        alignas(16) int16_t hi_lanes[8];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lo_lanes), lo);
+        _mm_store_si128(reinterpret_cast<__m128i*>(hi_lanes), hi);
+        for (int lane = 0; lane < 8; ++lane) {
+            low = std::min(low, lo_lanes[lane]);
+            high = std::max(high, hi_lanes[lane]);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        low = std::min(low, samples[i]);
+        high = std::max(high, samples[i]);
+    }
+}
+
+}  // namespace
+
+Decimator::Decimator(size_t factor, DecimateMode mode, int16_t* out)
+    : factor(factor), mode(mode), out(out), written(0), filled(0), sum(0), low(INT16_MAX), high(INT16_MIN) {
+    if (factor == 0) {
+        throw std::runtime_error("Decimation factor must be at least 1");
+    }
+}
+
+size_t Decimator::outputsFor(size_t len, size_t factor, DecimateMode mode) {
+    size_t groups = factor == 0 ? 0 : (len + factor - 1) / factor;
+    return mode == DecimateMode::MinMax ? groups * 2 : groups;
+}
+
+void Decimator::emit(int16_t first, int16_t second) {
+    out[written++] = first;
+    if (mode == DecimateMode::MinMax) {
+        out[written++] = second;
+    }
+}
+
+void Decimator::emitGroup() {
+    if (mode == DecimateMode::Average) {
+        emit(static_cast<int16_t>(std::lround(static_cast<double>(sum) / static_cast<double>(filled))));
+    } else {
+        // Pick keeps its sample in low
+        emit(low, high);
+    }
+    filled = 0;
+    sum = 0;
+    low = INT16_MAX;
+    high = INT16_MIN;
+}
+
+void Decimator::feedPartial(const int16_t* samples, size_t count) {
+    // Fold samples into the group in progress; count never crosses its end
+    switch (mode) {
+        case DecimateMode::Pick:
+            if (filled == 0) low = samples[0];
+            break;
+        case DecimateMode::Average:
+            sum += sumSamples(samples, count);
+            break;
+        case DecimateMode::MinMax:
+            minMaxSamples(samples, count, low, high);
+            break;
+    }
+    filled += count;
+    if (filled == factor) {
+        emitGroup();
+    }
+}
+
+void Decimator::feed(const int16_t* samples, size_t count) {
+    // Finish a group left open by the previous run
+    if (filled > 0 && count > 0) {
+        size_t take = std::min(factor - filled, count);
+        feedPartial(samples, take);
+        samples += take;
+        count -= take;
+    }
+
+    // Whole groups straight from the run
+    size_t groups = count / factor;
+    switch (mode) {
+        case DecimateMode::Pick:
+            for (size_t g = 0; g < groups; ++g) {
+                out[written++] = samples[g * factor];
+            }
+            break;
+        case DecimateMode::Average:
+            for (size_t g = 0; g < groups; ++g) {
+                int64_t total = sumSamples(samples + g * factor, factor);
+                out[written++] = static_cast<int16_t>(
+                    std::lround(static_cast<double>(total) / static_cast<double>(factor)));
+            }
+            break;
+        case DecimateMode::MinMax:
+            for (size_t g = 0; g < groups; ++g) {
+                int16_t group_low = INT16_MAX;
+                int16_t group_high = INT16_MIN;
+                minMaxSamples(samples + g * factor, factor, group_low, group_high);
+                out[written++] = group_low;
+                out[written++] = group_high;
+            }
+            break;
+    }
+    samples += groups * factor;
+    count -= groups * factor;
+
+    if (count > 0) {
+        feedPartial(samples, count);
+    }
+}
+
+void Decimator::finish() {
+    if (filled > 0) {
+        emitGroup();
+    }
+}
+
+}  // namespace AudioEditor
@@ -0,0 +1,58 @@
+#ifndef DECIMATE_HPP
+#define DECIMATE_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace AudioEditor {
+
+/**
+ * How readDecimated reduces each group of factor samples.
+ */
+enum class DecimateMode {
+    Pick,     // First sample of the group
+    Average,  // Mean, rounded to nearest
+    MinMax    // Two outputs per group: minimum then maximum (waveform thumbnails)
+};
+
+/**
+ * Reduces a stream of sample runs to one (or, for MinMax, two) outputs per
+ * group of factor samples. Runs may split groups anywhere; a partial
+ * group is carried over to the next feed. Full groups inside a run are
+ * reduced straight from the segment's memory with SSE2 where available
+ * and a scalar loop otherwise, so the full-rate data is never copied.
+ */
+class Decimator {
+private:
+    size_t factor;
+    DecimateMode mode;
+    int16_t* out;
+    size_t written;
+
+    // Group in progress
+    size_t filled;
+    int64_t sum;
+    int16_t low;
+    int16_t high;
+
+    void emit(int16_t first, int16_t second = 0);
+    void emitGroup();
+    void feedPartial(const int16_t* samples, size_t count);
+
+public:
+    // out must hold outputsFor(len, factor, mode) samples
+    Decimator(size_t factor, DecimateMode mode, int16_t* out);
+
+    void feed(const int16_t* samples, size_t count);
+
+    // Emit the trailing partial group, if any
+    void finish();
+
+    size_t outputCount() const { return written; }
+
+    static size_t outputsFor(size_t len, size_t factor, DecimateMode mode);
+};
+
+}  // namespace AudioEditor
+
+#endif  // DECIMATE_HPP
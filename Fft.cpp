@@ -0,0 +1,91 @@
+#include "Fft.hpp"
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+namespace AudioEditor {
+
+FftPlan::FftPlan(size_t size) : n(size) {
+    if (size < 2 || (size & (size - 1)) != 0) {
+        throw std::runtime_error("FFT size must be a power of two of at least 2");
+    }
+
+    const double pi = std::acos(-1.0);
+    size_t half = n / 2;
+    twiddles.resize(half / 2);
+    for (size_t k = 0; k < twiddles.size(); ++k) {
+        double angle = -2.0 * pi * static_cast<double>(k) / static_cast<double>(half);
+        twiddles[k] = std::complex<float>(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+    }
+    unpack.resize(half + 1);
+    for (size_t k = 0; k <= half; ++k) {
+        double angle = -2.0 * pi * static_cast<double>(k) / static_cast<double>(n);
+        unpack[k] = std::complex<float>(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+    }
+
+    reversed.resize(half);
+    size_t bits = 0;
+    while ((static_cast<size_t>(1) << bits) < half) ++bits;
+    for (size_t i = 0; i < half; ++i) {
+        size_t r = 0;
+        for (size_t b = 0; b < bits; ++b) {
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        reversed[i] = static_cast<uint32_t>(r);
+    }
+}
+
+void FftPlan::forward(const float* input, std::complex<float>* out, std::complex<float>* work) const {
+    size_t half = n / 2;
+
+    // Even samples become the real parts, odd samples the imaginary parts
+    for (size_t i = 0; i < half; ++i) {
+        work[reversed[i]] = std::complex<float>(input[2 * i], input[2 * i + 1]);
+    }
+
+    for (size_t len = 2; len <= half; len <<= 1) {
+        size_t step = half / len;
+        size_t span = len / 2;
+        for (size_t base = 0; base < half; base += len) {
+            for (size_t k = 0; k < span; ++k) {
+                std::complex<float> odd = work[base + k + span] * twiddles[k * step];
+                std::complex<float> even = work[base + k];
+                work[base + k] = even + odd;
+                work[base + k + span] = even - odd;
+            }
+        }
+    }
+
+    // Separate the spectra of the even and odd samples and combine them
+    for (size_t k = 0; k <= half; ++k) {
+        std::complex<float> z = work[k % half];
+        std::complex<float> mirror = std::conj(work[(half - k) % half]);
+        std::complex<float> even = 0.5f * (z + mirror);
+        std::complex<float> odd = std::complex<float>(0.0f, -0.5f) * (z - mirror);
+        out[k] = even + unpack[k] * odd;
+    }
+}
+
+void FftPlan::spectrum(const float* input, float* out, std::complex<float>* work, bool magnitude) const {
+    std::complex<float>* result = work + n / 2;
+    forward(input, result, work);
+    for (size_t k = 0; k < bins(); ++k) {
+        float power = std::norm(result[k]);
+        out[k] = magnitude ? std::sqrt(power) : power;
+    }
+}
+
+std::shared_ptr<const FftPlan> FftPlan::get(size_t size) {
+    static std::mutex mutex;
+    static std::map<size_t, std::shared_ptr<const FftPlan>> plans;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& plan = plans[size];
+    if (!plan) {
+        plan = std::make_shared<const FftPlan>(size);
+    }
+    return plan;
+}
+
+}  // namespace AudioEditor
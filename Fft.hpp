@@ -0,0 +1,45 @@
+#ifndef FFT_HPP
+#define FFT_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <complex>
+#include <memory>
+#include <vector>
+
+namespace AudioEditor {
+
+/**
+ * Precomputed radix-2 FFT of real input of a fixed power-of-two size.
+ * The n real samples are packed into n/2 complex values, transformed
+ * in place and unpacked into the n/2 + 1 non-negative frequency bins, so a
+ * real transform costs half a complex one. Plans are immutable and shared
+ * between threads; callers supply the scratch.
+ */
+class FftPlan {
+private:
+    size_t n;
+    std::vector<std::complex<float>> twiddles;  // e^(-2 pi i k / (n/2)), k < n/4
+    std::vector<std::complex<float>> unpack;    // e^(-2 pi i k / n), k <= n/2
+    std::vector<uint32_t> reversed;             // Bit-reversal permutation of n/2
+
+public:
+    explicit FftPlan(size_t size);
+
+    size_t size() const { return n; }
+    size_t bins() const { return n / 2 + 1; }
+
+    // bins() complex outputs; work must hold n/2 values
+    void forward(const float* input, std::complex<float>* out, std::complex<float>* work) const;
+
+    // |X[k]|^2 (or |X[k]| when magnitude is set) for each bin; work must hold workSize() values
+    void spectrum(const float* input, float* out, std::complex<float>* work, bool magnitude = false) const;
+    size_t workSize() const { return n / 2 + bins(); }
+
+    // Shared plan for size, built on first use
+    static std::shared_ptr<const FftPlan> get(size_t size);
+};
+
+}  // namespace AudioEditor
+
+#endif  // FFT_HPP
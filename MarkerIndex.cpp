@@ -0,0 +1,275 @@
+#include "MarkerIndex.hpp"
+#include <algorithm>
+
+namespace AudioEditor {
+
+MarkerIndex::MarkerIndex() : root(nullptr), next_id(1), rng(std::random_device{}()) {}
+
+void MarkerIndex::addShift(Node* node, size_t delta) {
+    node->marker.start += delta;
+    node->max_end += delta;
+    node->shift += delta;
+}
+
+void MarkerIndex::push(Node* node) {
+    if (node->shift != 0) {
+        if (node->left) addShift(node->left, node->shift);
+        if (node->right) addShift(node->right, node->shift);
+        node->shift = 0;
+    }
+}
+
+void MarkerIndex::pull(Node* node) {
+    node->max_end = reach(node->marker);
+    if (node->left) {
+        node->left->parent = node;
+        node->max_end = std::max(node->max_end, node->left->max_end);
+    }
+    if (node->right) {
+        node->right->parent = node;
+        node->max_end = std::max(node->max_end, node->right->max_end);
+    }
+}
+
+void MarkerIndex::split(Node* node, size_t pos, Node*& left, Node*& right) {
+    // left gets entries starting before pos, right the rest
+    if (!node) {
+        left = right = nullptr;
+        return;
+    }
+    push(node);
+    if (node->marker.start < pos) {
+        split(node->right, pos, node->right, right);
+        left = node;
+    } else {
+        split(node->left, pos, left, node->left);
+        right = node;
+    }
+    pull(node);
+}
+
+MarkerIndex::Node* MarkerIndex::merge(Node* left, Node* right) {
+    if (!left) return right;
+    if (!right) return left;
+    if (left->priority > right->priority) {
+        push(left);
+        left->right = merge(left->right, right);
+        pull(left);
+        return left;
+    }
+    push(right);
+    right->left = merge(left, right->left);
+    pull(right);
+    return right;
+}
+
+void MarkerIndex::pushPath(Node* node) {
+    // Apply every pending shift above node so its fields are current
+    std::vector<Node*> path;
+    for (Node* up = node->parent; up; up = up->parent) {
+        path.push_back(up);
+    }
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        push(*it);
+    }
+}
+
+void MarkerIndex::collect(Node* node, std::vector<Node*>& out) {
+    if (!node) return;
+    push(node);
+    collect(node->left, out);
+    out.push_back(node);
+    collect(node->right, out);
+}
+
+void MarkerIndex::resizeSpanning(Node* node, size_t pos, size_t del_end, size_t insert_len) {
+    // Every entry here starts before pos; only regions reaching past it change
+    if (!node || node->max_end <= pos) return;
+    push(node);
+    resizeSpanning(node->left, pos, del_end, insert_len);
+    resizeSpanning(node->right, pos, del_end, insert_len);
+
+    Marker& m = node->marker;
+    if (m.length > 0 && m.end() > pos) {
+        if (insert_len > 0) {
+            m.length += insert_len;
+        } else {
+            m.length -= std::min(m.end(), del_end) - pos;
+        }
+    }
+    pull(node);
+}
+
+void MarkerIndex::queryInto(Node* node, size_t start, size_t end, std::vector<Marker>& out) {
+    if (!node || node->max_end <= start) return;
+    push(node);
+    queryInto(node->left, start, end, out);
+    if (node->marker.start >= end) return;
+    if (reach(node->marker) > start) {
+        out.push_back(node->marker);
+    }
+    queryInto(node->right, start, end, out);
+}
+
+void MarkerIndex::insertLocked(const Marker& marker) {
+    auto owned = std::make_unique<Node>();
+    Node* node = owned.get();
+    node->marker = marker;
+    node->priority = static_cast<uint32_t>(rng());
+    node->shift = 0;
+    node->left = node->right = node->parent = nullptr;
+    pull(node);
+    by_id.emplace(marker.id, std::move(owned));
+
+    Node* before;
+    Node* after;
+    split(root, marker.start, before, after);
+    root = merge(merge(before, node), after);
+    root->parent = nullptr;
+}
+
+MarkerId MarkerIndex::add(size_t start, size_t length, const std::string& label) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    MarkerId id = next_id++;
+    insertLocked(Marker{id, start, length, label});
+    return id;
+}
+
+bool MarkerIndex::remove(MarkerId id) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto found = by_id.find(id);
+    if (found == by_id.end()) {
+        return false;
+    }
+    Node* node = found->second.get();
+    pushPath(node);
+    push(node);
+
+    Node* parent = node->parent;
+    Node* replacement = merge(node->left, node->right);
+    if (replacement) replacement->parent = parent;
+    if (!parent) {
+        root = replacement;
+    } else if (parent->left == node) {
+        parent->left = replacement;
+    } else {
+        parent->right = replacement;
+    }
+    for (Node* up = parent; up; up = up->parent) {
+        pull(up);
+    }
+
+    by_id.erase(found);
+    return true;
+}
+
+std::optional<Marker> MarkerIndex::get(MarkerId id) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto found = by_id.find(id);
+    if (found == by_id.end()) {
+        return std::nullopt;
+    }
+    pushPath(found->second.get());
+    return found->second->marker;
+}
+
+std::vector<Marker> MarkerIndex::query(size_t start, size_t len) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<Marker> out;
+    if (len > 0) {
+        size_t end = len > SIZE_MAX - start ? SIZE_MAX : start + len;
+        queryInto(root, start, end, out);
+    }
+    return out;
+}
+
+std::vector<Marker> MarkerIndex::all() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<Node*> nodes;
+    collect(root, nodes);
+    std::vector<Marker> out;
+    out.reserve(nodes.size());
+    for (Node* node : nodes) {
+        out.push_back(node->marker);
+    }
+    return out;
+}
+
+size_t MarkerIndex::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return by_id.size();
+}
+
+void MarkerIndex::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    root = nullptr;
+    by_id.clear();
+}
+
+void MarkerIndex::assign(const std::vector<Marker>& markers) {
+    std::lock_guard<std::mutex> lock(mutex);
+    root = nullptr;
+    by_id.clear();
+    for (const Marker& marker : markers) {
+        insertLocked(marker);
+        next_id = std::max(next_id, marker.id + 1);
+    }
+}
+
+void MarkerIndex::onInsert(size_t pos, size_t len) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (len == 0 || !root) return;
+
+    Node* before;
+    Node* after;
+    split(root, pos, before, after);
+    resizeSpanning(before, pos, pos, len);
+    if (after) addShift(after, len);
+    root = merge(before, after);
+    root->parent = nullptr;
+}
+
+void MarkerIndex::onDelete(size_t pos, size_t len) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (len == 0 || !root) return;
+
+    size_t del_end = pos + len;
+    Node* before;
+    Node* rest;
+    Node* inside;
+    Node* after;
+    split(root, pos, before, rest);
+    split(rest, del_end, inside, after);
+
+    resizeSpanning(before, pos, del_end, 0);
+    if (after) addShift(after, 0 - len);
+
+    // Entries starting inside the cut are few; rebuild them individually
+    std::vector<Node*> moved;
+    collect(inside, moved);
+    Node* kept = nullptr;
+    for (Node* node : moved) {
+        size_t old_end = node->marker.end();
+        bool region = node->marker.length > 0;
+        node->marker.start = pos;
+        node->marker.length = old_end > del_end ? old_end - del_end : 0;
+        if (region && node->marker.length == 0) {
+            by_id.erase(node->marker.id);
+            continue;
+        }
+        node->left = node->right = nullptr;
+        node->shift = 0;
+        pull(node);
+        kept = merge(kept, node);
+    }
+
+    root = merge(merge(before, kept), after);
+    if (root) root->parent = nullptr;
+}
+
+}  // namespace AudioEditor
@@ -0,0 +1,107 @@
+#ifndef MARKER_INDEX_HPP
+#define MARKER_INDEX_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace AudioEditor {
+
+using MarkerId = uint64_t;
+
+/**
+ * A labelled position (length 0) or region [start, start + length) on a
+ * track, e.g. an ad slot, a chapter mark or a span to redact.
+ */
+struct Marker {
+    MarkerId id;
+    size_t start;
+    size_t length;
+    std::string label;
+
+    size_t end() const { return start + length; }
+};
+
+/**
+ * Markers and regions that follow the audio through edits.
+ *
+ * Entries live in a treap ordered by start. Each node carries a pending
+ * shift for its whole subtree and the furthest end below it, so an edit
+ * moves every later entry with one split, one tag and one merge, and only
+ * the k regions spanning the edit point are visited: O(log n + k) per
+ * edit. Range queries prune on the furthest end and cost O(log n + hits).
+ *
+ * Edit rules:
+ *   insert at pos   entries starting at or after pos move right; regions
+ *                   strictly containing pos grow
+ *   delete range    entries after it move left; regions lose the deleted
+ *                   overlap and are dropped if nothing remains; positions
+ *                   inside it move to its start
+ *
+ * All calls are thread-safe.
+ */
+class MarkerIndex {
+private:
+    struct Node {
+        Marker marker;
+        uint32_t priority;
+        size_t shift;     // Pending for the subtree (applied modulo 2^64, so it may be "negative")
+        size_t max_end;   // Furthest reach in the subtree; positions count as one sample
+        Node* left;
+        Node* right;
+        Node* parent;
+    };
+
+    mutable std::mutex mutex;
+    Node* root;
+    std::unordered_map<MarkerId, std::unique_ptr<Node>> by_id;  // Owns the nodes
+    MarkerId next_id;
+    std::mt19937 rng;
+
+    static size_t reach(const Marker& m) { return m.start + (m.length > 0 ? m.length : 1); }
+    static void push(Node* node);
+    static void pull(Node* node);
+    static void addShift(Node* node, size_t delta);
+    static void split(Node* node, size_t pos, Node*& left, Node*& right);
+    static Node* merge(Node* left, Node* right);
+    static void pushPath(Node* node);
+    static void collect(Node* node, std::vector<Node*>& out);
+    static void resizeSpanning(Node* node, size_t pos, size_t del_end, size_t insert_len);
+    static void queryInto(Node* node, size_t start, size_t end, std::vector<Marker>& out);
+    void insertLocked(const Marker& marker);
+
+public:
+    MarkerIndex();
+
+    MarkerIndex(const MarkerIndex&) = delete;
+    MarkerIndex& operator=(const MarkerIndex&) = delete;
+
+    MarkerId add(size_t start, size_t length = 0, const std::string& label = "");
+    bool remove(MarkerId id);
+    std::optional<Marker> get(MarkerId id) const;
+
+    // Entries overlapping [start, start + len), in start order
+    std::vector<Marker> query(size_t start, size_t len) const;
+    std::vector<Marker> all() const;
+
+    size_t size() const;
+    void clear();
+
+    // Replace every entry with markers (ids kept), e.g. when a snapshot is
+    // restored; ids handed out later never collide with them
+    void assign(const std::vector<Marker>& markers);
+
+    // Called by the track after len samples are inserted at or removed from pos
+    void onInsert(size_t pos, size_t len);
+    void onDelete(size_t pos, size_t len);
+};
+
+}  // namespace AudioEditor
+
+#endif  // MARKER_INDEX_HPP
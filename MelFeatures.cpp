@@ -0,0 +1,214 @@
+#include "MelFeatures.hpp"
+#include "ScratchArena.hpp"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <tuple>
+
+namespace AudioEditor {
+
+namespace {
+
+std::shared_ptr<const MelFilterBank> bankFor(const MelConfig& config) {
+    return MelFilterBank::get(config.sample_rate, config.stft.resolvedFftSize(), config.mel_bands,
+                              config.low_hz, config.high_hz);
+}
+
+// Filter and log one block of spectra into rows of bank->bandCount() values
+void logMelBlock(const MelFilterBank& bank, float log_floor, const float* spectra, size_t frames, float* rows) {
+    size_t bins = bank.binCount();
+    size_t bands = bank.bandCount();
+    for (size_t f = 0; f < frames; ++f) {
+        float* row = rows + f * bands;
+        bank.apply(spectra + f * bins, row);
+        for (size_t b = 0; b < bands; ++b) {
+            row[b] = std::log(std::max(row[b], log_floor));
+        }
+    }
+}
+
+}  // namespace
+
+// ========== MelFilterBank Implementation ==========
+
+double MelFilterBank::hzToMel(double hz) {
+    return 2595.0 * std::log10(1.0 + hz / 700.0);
+}
+
+double MelFilterBank::melToHz(double mel) {
+    return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0);
+}
+
+MelFilterBank::MelFilterBank(uint32_t sample_rate, size_t fft_size, size_t mel_bands, float low_hz, float high_hz)
+    : bin_count(fft_size / 2 + 1) {
+    double nyquist = sample_rate / 2.0;
+    double high = high_hz > 0.0f ? high_hz : nyquist;
+    if (sample_rate == 0 || mel_bands == 0 || low_hz < 0.0f || high > nyquist || low_hz >= high) {
+        throw std::runtime_error("Invalid mel filter bank parameters");
+    }
+
+    // mel_bands triangles need mel_bands + 2 evenly spaced edges
+    double low_mel = hzToMel(low_hz);
+    double high_mel = hzToMel(high);
+    std::vector<double> edges(mel_bands + 2);
+    for (size_t i = 0; i < edges.size(); ++i) {
+        edges[i] = melToHz(low_mel + (high_mel - low_mel) * static_cast<double>(i) / (mel_bands + 1));
+    }
+
+    double bin_hz = static_cast<double>(sample_rate) / static_cast<double>(fft_size);
+    bands.resize(mel_bands);
+    for (size_t b = 0; b < mel_bands; ++b) {
+        double left = edges[b];
+        double centre = edges[b + 1];
+        double right = edges[b + 2];
+
+        Band& band = bands[b];
+        band.first_bin = bin_count;
+        for (size_t k = 0; k < bin_count; ++k) {
+            double hz = static_cast<double>(k) * bin_hz;
+            double weight = 0.0;
+            if (hz > left && hz < right) {
+                weight = hz <= centre ? (hz - left) / (centre - left) : (right - hz) / (right - centre);
+            }
+            if (weight > 0.0) {
+                if (band.weights.empty()) band.first_bin = k;
+                // Keep weights contiguous from the first covered bin
+                band.weights.resize(k - band.first_bin + 1, 0.0f);
+                band.weights.back() = static_cast<float>(weight);
+            }
+        }
+        if (band.weights.empty()) {
+            band.first_bin = 0;
+        }
+    }
+}
+
+void MelFilterBank::apply(const float* spectrum, float* mel) const {
+    for (size_t b = 0; b < bands.size(); ++b) {
+        const float* bins = spectrum + bands[b].first_bin;
+        const float* weights = bands[b].weights.data();
+        size_t count = bands[b].weights.size();
+        float sum = 0.0f;
+        for (size_t k = 0; k < count; ++k) {
+            sum += bins[k] * weights[k];
+        }
+        mel[b] = sum;
+    }
+}
+
+std::shared_ptr<const MelFilterBank> MelFilterBank::get(uint32_t sample_rate, size_t fft_size, size_t mel_bands,
+                                                        float low_hz, float high_hz) {
+    using Key = std::tuple<uint32_t, size_t, size_t, float, float>;
+    static std::mutex mutex;
+    static std::map<Key, std::shared_ptr<const MelFilterBank>> banks;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& bank = banks[Key(sample_rate, fft_size, mel_bands, low_hz, high_hz)];
+    if (!bank) {
+        bank = std::make_shared<const MelFilterBank>(sample_rate, fft_size, mel_bands, low_hz, high_hz);
+    }
+    return bank;
+}
+
+// ========== MelFeatures Implementation ==========
+
+std::vector<float> MelFeatures::dctMatrix(size_t coefficients, size_t bands) {
+    const double pi = std::acos(-1.0);
+    std::vector<float> matrix(coefficients * bands);
+    for (size_t i = 0; i < coefficients; ++i) {
+        double scale = std::sqrt((i == 0 ? 1.0 : 2.0) / static_cast<double>(bands));
+        for (size_t m = 0; m < bands; ++m) {
+            matrix[i * bands + m] = static_cast<float>(
+                scale * std::cos(pi * static_cast<double>(i) * (static_cast<double>(m) + 0.5) / bands));
+        }
+    }
+    return matrix;
+}
+
+size_t MelFeatures::logMel(const SoundSegment& track, size_t start, size_t len, const MelConfig& config,
+                           float* out, Scheduler& scheduler) {
+    auto bank = bankFor(config);
+    size_t bands = bank->bandCount();
+
+    return Spectrogram::forEachBlock(track, start, len, config.stft,
+        [&](size_t first_frame, size_t frames, const float* spectra) {
+            logMelBlock(*bank, config.log_floor, spectra, frames, out + first_frame * bands);
+        }, scheduler);
+}
+
+size_t MelFeatures::logMel(const SoundSegment& track, size_t start, size_t len, const MelConfig& config,
+                           std::vector<float>& out, Scheduler& scheduler) {
+    size_t length_now = track.length();
+    size_t available = start < length_now ? std::min(len, length_now - start) : 0;
+    out.resize(StftFrames::frameCount(available, config.stft) * config.mel_bands);
+    size_t frames = logMel(track, start, available, config, out.data(), scheduler);
+    out.resize(frames * config.mel_bands);
+    return frames;
+}
+
+size_t MelFeatures::mfcc(const SoundSegment& track, size_t start, size_t len, const MelConfig& config,
+                         float* out, Scheduler& scheduler) {
+    if (config.coefficients == 0 || config.coefficients > config.mel_bands) {
+        throw std::runtime_error("MFCC count must be between 1 and the number of mel bands");
+    }
+    auto bank = bankFor(config);
+    size_t bands = bank->bandCount();
+    size_t coefficients = config.coefficients;
+    std::vector<float> dct = dctMatrix(coefficients, bands);
+
+    return Spectrogram::forEachBlock(track, start, len, config.stft,
+        [&](size_t first_frame, size_t frames, const float* spectra) {
+            // Nested in the spectrogram block's scope on the same thread
+            ScratchScope scratch;
+            float* log_mel = scratch.allocateArray<float>(frames * bands);
+            logMelBlock(*bank, config.log_floor, spectra, frames, log_mel);
+
+            // Block of log-mel rows times the DCT matrix, transposed
+            for (size_t f = 0; f < frames; ++f) {
+                const float* row = log_mel + f * bands;
+                float* target = out + (first_frame + f) * coefficients;
+                for (size_t i = 0; i < coefficients; ++i) {
+                    const float* basis = dct.data() + i * bands;
+                    float sum = 0.0f;
+                    for (size_t m = 0; m < bands; ++m) {
+                        sum += row[m] * basis[m];
+                    }
+                    target[i] = sum;
+                }
+            }
+        }, scheduler);
+}
+
+size_t MelFeatures::mfcc(const SoundSegment& track, size_t start, size_t len, const MelConfig& config,
+                         std::vector<float>& out, Scheduler& scheduler) {
+    size_t length_now = track.length();
+    size_t available = start < length_now ? std::min(len, length_now - start) : 0;
+    out.resize(StftFrames::frameCount(available, config.stft) * config.coefficients);
+    size_t frames = mfcc(track, start, available, config, out.data(), scheduler);
+    out.resize(frames * config.coefficients);
+    return frames;
+}
+
+size_t MelFeatures::mfccBatch(const std::vector<const SoundSegment*>& tracks, const MelConfig& config,
+                              std::vector<float>& out, std::vector<size_t>& row_offsets, Scheduler& scheduler) {
+    std::vector<size_t> lengths(tracks.size());
+    row_offsets.assign(tracks.size() + 1, 0);
+    for (size_t i = 0; i < tracks.size(); ++i) {
+        if (!tracks[i]) {
+            throw std::runtime_error("Cannot extract features from a null track");
+        }
+        lengths[i] = tracks[i]->length();
+        row_offsets[i + 1] = row_offsets[i] + StftFrames::frameCount(lengths[i], config.stft);
+    }
+    out.assign(row_offsets.back() * config.coefficients, 0.0f);
+
+    // One task per track; each track's frames are spread further by mfcc
+    scheduler.parallelFor(tracks.size(), [&](size_t i) {
+        mfcc(*tracks[i], 0, lengths[i], config, out.data() + row_offsets[i] * config.coefficients, scheduler);
+    });
+    return row_offsets.back();
+}
+
+}  // namespace AudioEditor
@@ -0,0 +1,96 @@
+#ifndef MEL_FEATURES_HPP
+#define MEL_FEATURES_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "Stft.hpp"
+
+namespace AudioEditor {
+
+/**
+ * Parameters for log-mel and MFCC extraction. Framing and the FFT come
+ * from stft; power spectra are used unless stft.magnitude is set.
+ */
+struct MelConfig {
+    StftConfig stft;
+    uint32_t sample_rate = SAMPLE_RATE;
+    size_t mel_bands = 40;
+    float low_hz = 20.0f;
+    float high_hz = 0.0f;        // 0 selects the Nyquist frequency
+    float log_floor = 1e-10f;    // Energies are clamped here before the log
+    size_t coefficients = 13;    // MFCCs kept per frame
+};
+
+/**
+ * Triangular filters evenly spaced on the HTK mel scale. Each filter only
+ * covers the few FFT bins under its triangle, so it is stored as a start
+ * bin plus contiguous weights and applied as a short dot product rather
+ * than a row of a dense bands x bins matrix. Banks are immutable and
+ * cached per (sample rate, FFT size, bands, edges).
+ */
+class MelFilterBank {
+private:
+    struct Band {
+        size_t first_bin;
+        std::vector<float> weights;
+    };
+
+    size_t bin_count;
+    std::vector<Band> bands;
+
+public:
+    MelFilterBank(uint32_t sample_rate, size_t fft_size, size_t mel_bands, float low_hz, float high_hz);
+
+    size_t bandCount() const { return bands.size(); }
+    size_t binCount() const { return bin_count; }
+
+    // mel[b] = sum of spectrum[k] * weight_b(k); spectrum holds binCount() values
+    void apply(const float* spectrum, float* mel) const;
+
+    static std::shared_ptr<const MelFilterBank> get(uint32_t sample_rate, size_t fft_size, size_t mel_bands,
+                                                    float low_hz, float high_hz);
+
+    static double hzToMel(double hz);
+    static double melToHz(double mel);
+};
+
+/**
+ * Log-mel energies and MFCCs computed natively from a track. Frames are
+ * transformed in blocks on the scheduler (see Spectrogram::forEachBlock);
+ * each block is filtered, logged and, for MFCCs, passed through an
+ * orthonormal DCT-II straight into the caller's row-major matrix, so the
+ * full spectrogram is never materialised.
+ */
+class MelFeatures {
+public:
+    // Write frames x mel_bands natural-log energies; returns the frame count
+    static size_t logMel(const SoundSegment& track, size_t start, size_t len, const MelConfig& config,
+                         float* out, Scheduler& scheduler = Scheduler::instance());
+    static size_t logMel(const SoundSegment& track, size_t start, size_t len, const MelConfig& config,
+                         std::vector<float>& out, Scheduler& scheduler = Scheduler::instance());
+
+    // Write frames x coefficients MFCCs; returns the frame count
+    static size_t mfcc(const SoundSegment& track, size_t start, size_t len, const MelConfig& config,
+                       float* out, Scheduler& scheduler = Scheduler::instance());
+    static size_t mfcc(const SoundSegment& track, size_t start, size_t len, const MelConfig& config,
+                       std::vector<float>& out, Scheduler& scheduler = Scheduler::instance());
+
+    /**
+     * MFCCs for whole tracks, stacked into one matrix. Track i fills rows
+     * [row_offsets[i], row_offsets[i + 1]). Tracks are processed in
+     * parallel. Returns the total row count.
+     */
+    static size_t mfccBatch(const std::vector<const SoundSegment*>& tracks, const MelConfig& config,
+                            std::vector<float>& out, std::vector<size_t>& row_offsets,
+                            Scheduler& scheduler = Scheduler::instance());
+
+    // coefficients x bands orthonormal DCT-II matrix, row-major
+    static std::vector<float> dctMatrix(size_t coefficients, size_t bands);
+};
+
+}  // namespace AudioEditor
+
+#endif  // MEL_FEATURES_HPP
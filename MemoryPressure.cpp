@@ -0,0 +1,302 @@
+#include "MemoryPressure.hpp"
+#include "ScratchArena.hpp"
+#include "SegmentTable.hpp"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace AudioEditor {
+
+namespace {
+
+// Stall of 150 ms within any 1 s window wakes the monitor early
+const char* PSI_TRIGGER = "some 150000 1000000";
+
+bool readNumber(const std::string& path, size_t& value) {
+    std::ifstream file(path);
+    std::string text;
+    if (!file || !(file >> text) || text == "max") {
+        return false;
+    }
+    try {
+        value = static_cast<size_t>(std::stoull(text));
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+// Parse "some avg10=1.23 ..." from a PSI file
+double readPsiSomeAvg10(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 4, "some") != 0) continue;
+        size_t at = line.find("avg10=");
+        if (at == std::string::npos) break;
+        try {
+            return std::stod(line.substr(at + 6));
+        } catch (const std::exception&) {
+            break;
+        }
+    }
+    return -1.0;
+}
+
+// Directory of this process's cgroup v2 hierarchy, or empty
+std::string cgroupV2Path() {
+    std::ifstream file("/proc/self/cgroup");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.compare(0, 3, "0::") == 0) {
+            std::string path = "/sys/fs/cgroup" + line.substr(3);
+            std::ifstream probe(path + "/memory.current");
+            return probe ? path : std::string();
+        }
+    }
+    return std::string();
+}
+
+}  // namespace
+
+MemoryPressureMonitor::MemoryPressureMonitor()
+    : next_id(1), running(false), last_level(static_cast<int>(MemoryPressureLevel::Normal)) {
+    // Scratch arenas are thread-local: busy ones shrink at their next reset,
+    // idle scheduler workers are woken to release theirs straight away
+    registerCache([](MemoryPressureLevel) {
+        ScratchArena::requestTrim();
+        return size_t(0);
+    });
+
+    // Segment tables are rebuilt from the segment lists on demand
+    registerCache([](MemoryPressureLevel) {
+        return SegmentTableCache::trimAll();
+    });
+}
+
+MemoryPressureMonitor::~MemoryPressureMonitor() {
+    stop();
+}
+
+MemoryPressureMonitor& MemoryPressureMonitor::instance() {
+    static MemoryPressureMonitor monitor;
+    return monitor;
+}
+
+size_t MemoryPressureMonitor::registerCache(TrimFunction trim) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t id = next_id++;
+    caches[id] = std::move(trim);
+    return id;
+}
+
+void MemoryPressureMonitor::unregisterCache(size_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    caches.erase(id);
+}
+
+size_t MemoryPressureMonitor::addListener(Listener listener) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t id = next_id++;
+    listeners[id] = std::move(listener);
+    return id;
+}
+
+void MemoryPressureMonitor::removeListener(size_t id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    listeners.erase(id);
+}
+
+void MemoryPressureMonitor::setProbe(Probe custom) {
+    std::lock_guard<std::mutex> lock(mutex);
+    probe = std::move(custom);
+}
+
+MemoryPressureSample MemoryPressureMonitor::readSystem() {
+    MemoryPressureSample sample;
+
+    std::string cgroup = cgroupV2Path();
+    if (!cgroup.empty()) {
+        readNumber(cgroup + "/memory.current", sample.usage_bytes);
+        readNumber(cgroup + "/memory.max", sample.limit_bytes);
+        sample.psi_some_avg10 = readPsiSomeAvg10(cgroup + "/memory.pressure");
+    } else if (readNumber("/sys/fs/cgroup/memory/memory.usage_in_bytes", sample.usage_bytes)) {
+        // cgroup v1 reports "no limit" as a huge number
+        size_t limit = 0;
+        if (readNumber("/sys/fs/cgroup/memory/memory.limit_in_bytes", limit) && limit < (size_t(1) << 60)) {
+            sample.limit_bytes = limit;
+        }
+    }
+
+    // Without a cgroup limit, fall back to whole-machine figures
+    if (sample.limit_bytes == 0) {
+        std::ifstream meminfo("/proc/meminfo");
+        std::string key;
+        size_t value = 0;
+        std::string unit;
+        size_t total = 0;
+        size_t available = 0;
+        while (meminfo >> key >> value >> unit) {
+            if (key == "MemTotal:") total = value * 1024;
+            if (key == "MemAvailable:") available = value * 1024;
+        }
+        if (total > 0 && available <= total) {
+            sample.limit_bytes = total;
+            sample.usage_bytes = total - available;
+        }
+    }
+
+    if (sample.psi_some_avg10 < 0) {
+        sample.psi_some_avg10 = readPsiSomeAvg10("/proc/pressure/memory");
+    }
+    return sample;
+}
+
+MemoryPressureLevel MemoryPressureMonitor::classify(const MemoryPressureSample& sample) {
+    double ratio = sample.limit_bytes > 0
+                       ? static_cast<double>(sample.usage_bytes) / sample.limit_bytes : 0.0;
+
+    if (ratio >= MEMORY_CRITICAL_RATIO || sample.psi_some_avg10 >= PSI_CRITICAL_PERCENT) {
+        return MemoryPressureLevel::Critical;
+    }
+    if (ratio >= MEMORY_MODERATE_RATIO || sample.psi_some_avg10 >= PSI_MODERATE_PERCENT) {
+        return MemoryPressureLevel::Moderate;
+    }
+    return MemoryPressureLevel::Normal;
+}
+
+size_t MemoryPressureMonitor::trim(MemoryPressureLevel level) {
+    std::map<size_t, TrimFunction> targets;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        targets = caches;
+    }
+
+    size_t released = 0;
+    for (auto& entry : targets) {
+        released += entry.second(level);
+    }
+
+#ifdef __GLIBC__
+    // Hand freed pages back to the OS so the cgroup sees the drop
+    if (level == MemoryPressureLevel::Critical) {
+        malloc_trim(0);
+    }
+#endif
+    return released;
+}
+
+MemoryPressureLevel MemoryPressureMonitor::poll() {
+    Probe reader;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        reader = probe;
+    }
+
+    MemoryPressureSample sample = reader ? reader() : readSystem();
+    MemoryPressureLevel level = classify(sample);
+    last_level.store(static_cast<int>(level), std::memory_order_relaxed);
+
+    if (level != MemoryPressureLevel::Normal) {
+        trim(level);
+
+        std::map<size_t, Listener> targets;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            targets = listeners;
+        }
+        for (auto& entry : targets) {
+            entry.second(level, sample);
+        }
+    }
+    return level;
+}
+
+MemoryPressureLevel MemoryPressureMonitor::lastLevel() const {
+    return static_cast<MemoryPressureLevel>(last_level.load(std::memory_order_relaxed));
+}
+
+void MemoryPressureMonitor::run(std::chrono::milliseconds interval) {
+#ifdef __linux__
+    // Prefer a kernel PSI trigger so pressure spikes are seen between polls
+    int trigger_fd = -1;
+    std::string cgroup = cgroupV2Path();
+    for (const std::string& path : {cgroup.empty() ? std::string() : cgroup + "/memory.pressure",
+                                    std::string("/proc/pressure/memory")}) {
+        if (path.empty()) continue;
+        int fd = open(path.c_str(), O_RDWR | O_NONBLOCK);
+        if (fd < 0) continue;
+        if (write(fd, PSI_TRIGGER, strlen(PSI_TRIGGER) + 1) >= 0) {
+            trigger_fd = fd;
+            break;
+        }
+        close(fd);
+    }
+#endif
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        lock.unlock();
+        poll();
+
+#ifdef __linux__
+        if (trigger_fd >= 0) {
+            // Wake on a PSI event or after the polling interval, in short
+            // slices so stop() is honoured promptly
+            auto until = std::chrono::steady_clock::now() + interval;
+            bool triggered = false;
+            while (!triggered && std::chrono::steady_clock::now() < until) {
+                {
+                    std::lock_guard<std::mutex> check(mutex);
+                    if (!running) break;
+                }
+                struct pollfd pfd = {trigger_fd, POLLPRI, 0};
+                triggered = ::poll(&pfd, 1, 100) > 0 && (pfd.revents & POLLPRI);
+            }
+            lock.lock();
+            continue;
+        }
+#endif
+
+        lock.lock();
+        stop_cv.wait_for(lock, interval, [this] { return !running; });
+    }
+
+#ifdef __linux__
+    if (trigger_fd >= 0) {
+        close(trigger_fd);
+    }
+#endif
+}
+
+void MemoryPressureMonitor::start(std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) return;
+    running = true;
+    worker = std::thread(&MemoryPressureMonitor::run, this, interval);
+}
+
+void MemoryPressureMonitor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) return;
+        running = false;
+    }
+    stop_cv.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+}  // namespace AudioEditor
@@ -0,0 +1,102 @@
+#ifndef MEMORY_PRESSURE_HPP
+#define MEMORY_PRESSURE_HPP
+
+#include <stddef.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace AudioEditor {
+
+// Usage/limit ratios at which the monitor reports elevated pressure
+constexpr double MEMORY_MODERATE_RATIO = 0.80;
+constexpr double MEMORY_CRITICAL_RATIO = 0.95;
+// PSI "some" avg10 percentages at which the monitor reports elevated pressure
+constexpr double PSI_MODERATE_PERCENT = 10.0;
+constexpr double PSI_CRITICAL_PERCENT = 40.0;
+
+enum class MemoryPressureLevel {
+    Normal,
+    Moderate,  // Drop caches that are cheap to rebuild
+    Critical   // Drop everything that can be dropped and compact the heap
+};
+
+/**
+ * One reading of memory usage. limit_bytes == 0 means no limit is known;
+ * psi_some_avg10 < 0 means pressure-stall information is unavailable.
+ */
+struct MemoryPressureSample {
+    size_t usage_bytes = 0;
+    size_t limit_bytes = 0;
+    double psi_some_avg10 = -1.0;
+};
+
+/**
+ * Watches the process's cgroup (v2 memory.current/memory.max and
+ * memory.pressure, v1 usage/limit files, or /proc/meminfo as a last resort)
+ * and trims registered caches when usage nears the limit.
+ *
+ * The background thread waits on a PSI trigger when the kernel supports one
+ * and otherwise polls at a fixed interval. Hosts can register listeners to
+ * react to the same events, or call poll() themselves instead of start().
+ */
+class MemoryPressureMonitor {
+public:
+    // Trims a cache for the given level and returns the bytes it released
+    using TrimFunction = std::function<size_t(MemoryPressureLevel)>;
+    using Listener = std::function<void(MemoryPressureLevel, const MemoryPressureSample&)>;
+    using Probe = std::function<MemoryPressureSample()>;
+
+private:
+    std::mutex mutex;
+    std::map<size_t, TrimFunction> caches;
+    std::map<size_t, Listener> listeners;
+    size_t next_id;
+    Probe probe;
+
+    std::thread worker;
+    std::condition_variable stop_cv;
+    bool running;
+    std::atomic<int> last_level;
+
+    MemoryPressureMonitor();
+    void run(std::chrono::milliseconds interval);
+
+public:
+    ~MemoryPressureMonitor();
+
+    MemoryPressureMonitor(const MemoryPressureMonitor&) = delete;
+    MemoryPressureMonitor& operator=(const MemoryPressureMonitor&) = delete;
+
+    static MemoryPressureMonitor& instance();
+
+    size_t registerCache(TrimFunction trim);
+    void unregisterCache(size_t id);
+    size_t addListener(Listener listener);
+    void removeListener(size_t id);
+
+    // Replace the source of readings (tests, hosts with their own metrics)
+    void setProbe(Probe custom);
+
+    // Take one reading, trim caches and notify listeners if pressure is elevated
+    MemoryPressureLevel poll();
+
+    // Trim every registered cache and compact the heap; returns bytes released
+    size_t trim(MemoryPressureLevel level);
+
+    void start(std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
+    void stop();
+
+    MemoryPressureLevel lastLevel() const;
+
+    static MemoryPressureSample readSystem();
+    static MemoryPressureLevel classify(const MemoryPressureSample& sample);
+};
+
+}  // namespace AudioEditor
+
+#endif  // MEMORY_PRESSURE_HPP
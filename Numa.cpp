@@ -0,0 +1,149 @@
+#include "Numa.hpp"
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+namespace AudioEditor {
+
+namespace {
+
+#ifdef __linux__
+// Values from <numaif.h>; spelled out so libnuma headers are not required
+constexpr int MPOL_PREFERRED_MODE = 1;
+constexpr int MPOL_INTERLEAVE_MODE = 3;
+constexpr unsigned long MPOL_F_NODE_FLAG = 1UL << 0;
+constexpr unsigned long MPOL_F_ADDR_FLAG = 1UL << 1;
+constexpr size_t NODE_MASK_BITS = 1024;
+constexpr size_t BITS_PER_WORD = sizeof(unsigned long) * 8;
+#endif
+
+// Parse a sysfs CPU list such as "0-3,8-11"
+std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            // Ignore malformed entries
+        }
+    }
+    return cpus;
+}
+
+}  // namespace
+
+NumaTopology::NumaTopology() {
+#ifdef __linux__
+    for (int node = 0; node < static_cast<int>(NODE_MASK_BITS); ++node) {
+        std::ifstream list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!list) break;
+        std::string text;
+        std::getline(list, text);
+        node_cpus.push_back(parseCpuList(text));
+    }
+#endif
+    if (node_cpus.empty()) {
+        node_cpus.push_back(std::vector<int>());
+    }
+}
+
+const NumaTopology& NumaTopology::instance() {
+    static const NumaTopology topology;
+    return topology;
+}
+
+const std::vector<int>& NumaTopology::cpusOfNode(int node) const {
+    if (node < 0 || static_cast<size_t>(node) >= node_cpus.size()) {
+        node = 0;
+    }
+    return node_cpus[node];
+}
+
+int NumaTopology::currentNode() const {
+    if (!isNuma()) return 0;
+#ifdef __linux__
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+        return static_cast<int>(node);
+    }
+#endif
+    return 0;
+}
+
+int NumaTopology::nodeOfAddress(const void* addr) const {
+    if (!addr) return -1;
+    if (!isNuma()) return 0;
+#ifdef __linux__
+    int node = -1;
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0, const_cast<void*>(addr),
+                MPOL_F_NODE_FLAG | MPOL_F_ADDR_FLAG) == 0) {
+        return node;
+    }
+#endif
+    return -1;
+}
+
+bool NumaTopology::preferNode(void* addr, size_t bytes, int node) const {
+    if (!isNuma() || !addr || bytes == 0 || node < 0 || static_cast<size_t>(node) >= nodeCount()) {
+        return false;
+    }
+#ifdef __linux__
+    unsigned long mask[NODE_MASK_BITS / BITS_PER_WORD] = {};
+    mask[node / BITS_PER_WORD] |= 1UL << (node % BITS_PER_WORD);
+    return syscall(SYS_mbind, addr, bytes, MPOL_PREFERRED_MODE, mask, NODE_MASK_BITS, 0) == 0;
+#else
+    return false;
+#endif
+}
+
+bool NumaTopology::interleave(void* addr, size_t bytes) const {
+    if (!isNuma() || !addr || bytes == 0) {
+        return false;
+    }
+#ifdef __linux__
+    unsigned long mask[NODE_MASK_BITS / BITS_PER_WORD] = {};
+    for (size_t node = 0; node < nodeCount(); ++node) {
+        mask[node / BITS_PER_WORD] |= 1UL << (node % BITS_PER_WORD);
+    }
+    return syscall(SYS_mbind, addr, bytes, MPOL_INTERLEAVE_MODE, mask, NODE_MASK_BITS, 0) == 0;
+#else
+    return false;
+#endif
+}
+
+bool NumaTopology::pinCurrentThread(int node) const {
+    if (!isNuma()) return false;
+#ifdef __linux__
+    const auto& cpus = cpusOfNode(node);
+    if (cpus.empty()) return false;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)node;
+    return false;
+#endif
+}
+
+}  // namespace AudioEditor
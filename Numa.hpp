@@ -0,0 +1,45 @@
+#ifndef NUMA_HPP
+#define NUMA_HPP
+
+#include <stddef.h>
+#include <vector>
+
+namespace AudioEditor {
+
+/**
+ * NUMA topology discovered from /sys/devices/system/node, with thin wrappers
+ * around the Linux memory-policy syscalls. On non-Linux systems, or when the
+ * machine has a single node, everything reports node 0 and the placement
+ * calls are no-ops, so callers never need to special-case either situation.
+ */
+class NumaTopology {
+private:
+    std::vector<std::vector<int>> node_cpus;  // CPUs belonging to each node
+
+    NumaTopology();
+
+public:
+    static const NumaTopology& instance();
+
+    size_t nodeCount() const { return node_cpus.size(); }
+    bool isNuma() const { return node_cpus.size() > 1; }
+    const std::vector<int>& cpusOfNode(int node) const;
+
+    // Node of the CPU the calling thread is running on
+    int currentNode() const;
+
+    // Node backing the page containing addr, or -1 if it cannot be determined
+    int nodeOfAddress(const void* addr) const;
+
+    // Apply a placement policy to untouched pages [addr, addr + bytes).
+    // Return false (leaving the default first-touch policy) if unsupported.
+    bool preferNode(void* addr, size_t bytes, int node) const;
+    bool interleave(void* addr, size_t bytes) const;
+
+    // Restrict the calling thread to the CPUs of one node
+    bool pinCurrentThread(int node) const;
+};
+
+}  // namespace AudioEditor
+
+#endif  // NUMA_HPP
@@ -0,0 +1,116 @@
+#ifndef OPERATION_CONTROL_HPP
+#define OPERATION_CONTROL_HPP
+
+#include <stddef.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace AudioEditor {
+
+// Number of samples processed between cancellation/deadline/progress checks
+constexpr size_t CONTROL_BLOCK_SAMPLES = 65536;
+
+/**
+ * Base class for errors raised when a long-running operation is stopped early.
+ */
+class OperationAborted : public std::runtime_error {
+public:
+    explicit OperationAborted(const std::string& what) : std::runtime_error(what) {}
+};
+
+/**
+ * Raised when an operation observes that its cancellation token was triggered.
+ */
+class OperationCancelled : public OperationAborted {
+public:
+    explicit OperationCancelled(const std::string& what) : OperationAborted(what) {}
+};
+
+/**
+ * Raised when an operation runs past its deadline.
+ */
+class DeadlineExceeded : public OperationAborted {
+public:
+    explicit DeadlineExceeded(const std::string& what) : OperationAborted(what) {}
+};
+
+/**
+ * Shared cancellation flag. Copies refer to the same flag, so the scheduler
+ * can keep one copy and hand another to the operation it wants to abort.
+ */
+class CancellationToken {
+private:
+    std::shared_ptr<std::atomic<bool>> flag;
+
+public:
+    CancellationToken() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() { flag->store(true, std::memory_order_relaxed); }
+    bool isCancelled() const { return flag->load(std::memory_order_relaxed); }
+};
+
+/**
+ * Limits and observers for a long-running operation (identify, WAV load/save).
+ * All checks happen once per block of samples, so the per-sample cost is zero.
+ */
+struct OperationControl {
+    using Clock = std::chrono::steady_clock;
+    using ProgressCallback = std::function<void(size_t completed, size_t total)>;
+
+    std::shared_ptr<const CancellationToken> token;  // Optional cancellation source
+    Clock::time_point deadline = Clock::time_point::max();
+    ProgressCallback progress;                        // Optional progress observer
+    size_t block_size = CONTROL_BLOCK_SAMPLES;        // Samples between checks
+
+    OperationControl() = default;
+
+    OperationControl& withToken(const CancellationToken& t) {
+        token = std::make_shared<const CancellationToken>(t);
+        return *this;
+    }
+
+    OperationControl& withDeadline(Clock::time_point when) {
+        deadline = when;
+        return *this;
+    }
+
+    OperationControl& withTimeout(Clock::duration timeout) {
+        deadline = Clock::now() + timeout;
+        return *this;
+    }
+
+    OperationControl& withProgress(ProgressCallback cb) {
+        progress = std::move(cb);
+        return *this;
+    }
+
+    /**
+     * Report progress and abort if cancelled or past the deadline.
+     * Throws OperationCancelled or DeadlineExceeded.
+     */
+    void checkpoint(size_t completed, size_t total) const {
+        if (token && token->isCancelled()) {
+            throw OperationCancelled("Operation cancelled");
+        }
+        if (deadline != Clock::time_point::max() && Clock::now() >= deadline) {
+            throw DeadlineExceeded("Operation deadline exceeded");
+        }
+        if (progress) {
+            progress(completed, total);
+        }
+    }
+
+    // Shared instance with no limits, used by the plain overloads
+    static const OperationControl& unbounded() {
+        static const OperationControl none;
+        return none;
+    }
+};
+
+}  // namespace AudioEditor
+
+#endif  // OPERATION_CONTROL_HPP
@@ -0,0 +1,79 @@
+#include "RangeLock.hpp"
+#include <algorithm>
+
+namespace AudioEditor {
+
+RangeLockTable::Held* RangeLockTable::find(size_t ticket) {
+    for (auto& entry : held) {
+        if (entry.ticket == ticket) return &entry.range;
+    }
+    return nullptr;
+}
+
+bool RangeLockTable::conflicts(size_t start, size_t end, RangeLockMode mode, size_t ignore_ticket) const {
+    for (const auto& entry : held) {
+        if (entry.ticket == ignore_ticket) continue;
+        const Held& other = entry.range;
+        bool overlap = start < other.end && other.start < end;
+        if (overlap && (mode == RangeLockMode::Exclusive || other.mode == RangeLockMode::Exclusive)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t RangeLockTable::acquire(size_t start, size_t end, RangeLockMode mode) {
+    // Empty ranges still need a slot so extendDown has something to grow
+    end = std::max(end, start + 1);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    released.wait(lock, [&] { return !conflicts(start, end, mode, 0); });
+
+    size_t ticket = next_ticket++;
+    held.push_back(Entry{ticket, Held{start, end, mode}});
+    return ticket;
+}
+
+size_t RangeLockTable::tryAcquire(size_t start, size_t end, RangeLockMode mode) {
+    end = std::max(end, start + 1);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (conflicts(start, end, mode, 0)) {
+        return 0;
+    }
+
+    size_t ticket = next_ticket++;
+    held.push_back(Entry{ticket, Held{start, end, mode}});
+    return ticket;
+}
+
+void RangeLockTable::extendDown(size_t ticket, size_t new_start) {
+    std::unique_lock<std::mutex> lock(mutex);
+    Held* range = find(ticket);
+    if (!range || new_start >= range->start) {
+        return;
+    }
+
+    size_t old_start = range->start;
+    RangeLockMode mode = range->mode;
+    released.wait(lock, [&] { return !conflicts(new_start, old_start, mode, ticket); });
+
+    // Other tickets came and went while waiting, so the entry may have moved
+    find(ticket)->start = new_start;
+}
+
+void RangeLockTable::release(size_t ticket) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < held.size(); ++i) {
+            if (held[i].ticket == ticket) {
+                held[i] = held.back();
+                held.pop_back();
+                break;
+            }
+        }
+    }
+    released.notify_all();
+}
+
+}  // namespace AudioEditor
@@ -0,0 +1,125 @@
+#ifndef RANGE_LOCK_HPP
+#define RANGE_LOCK_HPP
+
+#include <stddef.h>
+#include <condition_variable>
+#include <limits>
+#include <vector>
+#include <mutex>
+
+namespace AudioEditor {
+
+// Upper bound used for "from here to the end of the track" locks
+constexpr size_t RANGE_LOCK_END = std::numeric_limits<size_t>::max();
+
+enum class RangeLockMode {
+    Shared,    // Readers; compatible with other shared holders
+    Exclusive  // Writers and structural edits
+};
+
+/**
+ * Table of locked sample ranges [start, end) for one track. Two requests
+ * conflict only if their ranges overlap and at least one is exclusive, so
+ * edits to disjoint regions proceed in parallel.
+ */
+class RangeLockTable {
+private:
+    struct Held {
+        size_t start;
+        size_t end;
+        RangeLockMode mode;
+    };
+
+    struct Entry {
+        size_t ticket;
+        Held range;
+    };
+
+    std::mutex mutex;
+    std::condition_variable released;
+    std::vector<Entry> held;  // Few entries at a time; a flat scan is cheapest
+    size_t next_ticket;
+
+    Held* find(size_t ticket);
+
+    bool conflicts(size_t start, size_t end, RangeLockMode mode, size_t ignore_ticket) const;
+
+public:
+    RangeLockTable() : next_ticket(1) {}
+
+    RangeLockTable(const RangeLockTable&) = delete;
+    RangeLockTable& operator=(const RangeLockTable&) = delete;
+
+    // Block until [start, end) can be held in the given mode; returns a ticket
+    size_t acquire(size_t start, size_t end, RangeLockMode mode);
+
+    // Non-blocking acquire; returns 0 if the range is busy
+    size_t tryAcquire(size_t start, size_t end, RangeLockMode mode);
+
+    // Grow a held range downwards to new_start, waiting for the extra part
+    void extendDown(size_t ticket, size_t new_start);
+
+    void release(size_t ticket);
+};
+
+/**
+ * RAII holder for one range in a RangeLockTable. Move-only.
+ */
+class RangeLock {
+private:
+    RangeLockTable* table;
+    size_t ticket;
+
+public:
+    RangeLock() : table(nullptr), ticket(0) {}
+    RangeLock(RangeLockTable& t, size_t start, size_t end, RangeLockMode mode)
+        : table(&t), ticket(t.acquire(start, end, mode)) {}
+    ~RangeLock() { unlock(); }
+
+    RangeLock(RangeLock&& other) noexcept : table(other.table), ticket(other.ticket) {
+        other.table = nullptr;
+        other.ticket = 0;
+    }
+
+    RangeLock& operator=(RangeLock&& other) noexcept {
+        if (this != &other) {
+            unlock();
+            table = other.table;
+            ticket = other.ticket;
+            other.table = nullptr;
+            other.ticket = 0;
+        }
+        return *this;
+    }
+
+    RangeLock(const RangeLock&) = delete;
+    RangeLock& operator=(const RangeLock&) = delete;
+
+    // Adopt a ticket obtained from tryAcquire
+    static RangeLock adopt(RangeLockTable& t, size_t ticket) {
+        RangeLock lock;
+        if (ticket != 0) {
+            lock.table = &t;
+            lock.ticket = ticket;
+        }
+        return lock;
+    }
+
+    bool ownsLock() const { return ticket != 0; }
+
+    void extendDown(size_t new_start) {
+        if (table) table->extendDown(ticket, new_start);
+    }
+
+    void unlock() {
+        if (table) {
+            table->release(ticket);
+            table = nullptr;
+            ticket = 0;
+        }
+    }
+};
+
+}  // namespace AudioEditor
+
+#endif  // RANGE_LOCK_HPP
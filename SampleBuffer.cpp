@@ -0,0 +1,146 @@
+#include "SampleBuffer.hpp"
+#include "Numa.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define AUDIO_EDITOR_HAVE_MMAP 1
+#endif
+
+namespace AudioEditor {
+
+namespace {
+
+std::atomic<size_t> interleave_threshold(NUMA_INTERLEAVE_MIN_BYTES);
+
+}  // namespace
+
+/**
+ * SampleBuffer with room for N samples inside the object. make_shared puts
+ * the control block, header and samples in one allocation.
+ */
+template <size_t N>
+class InlineSampleBuffer : public SampleBuffer {
+private:
+    int16_t storage[N];
+
+public:
+    explicit InlineSampleBuffer(size_t used) {
+        std::memset(storage, 0, sizeof(storage));
+        samples = storage;
+        count = used;
+        inline_storage = true;
+        numa_node = NumaTopology::instance().currentNode();
+    }
+};
+
+/**
+ * SampleBuffer that owns a std::vector moved in by the caller.
+ */
+class VectorSampleBuffer : public SampleBuffer {
+private:
+    std::vector<int16_t> storage;
+
+public:
+    explicit VectorSampleBuffer(std::vector<int16_t>&& adopted) : storage(std::move(adopted)) {
+        samples = storage.data();
+        count = storage.size();
+        release = [](int16_t*) {};  // The vector frees itself with the object
+        numa_node = NumaTopology::instance().nodeOfAddress(samples);
+    }
+};
+
+namespace {
+
+// Size classes keep a three-sample patch from paying for sixty-four
+template <size_t N>
+std::shared_ptr<SampleBuffer> allocateInline(size_t count) {
+    return std::make_shared<InlineSampleBuffer<N>>(count);
+}
+
+}  // namespace
+
+SampleBuffer::SampleBuffer()
+    : samples(nullptr), count(0), mapped_bytes(0), numa_node(0), shared(false), inline_storage(false) {
+}
+
+SampleBuffer::~SampleBuffer() {
+    if (inline_storage) {
+        return;
+    }
+    if (release) {
+        release(samples);
+        return;
+    }
+#ifdef AUDIO_EDITOR_HAVE_MMAP
+    if (mapped_bytes > 0) {
+        munmap(samples, mapped_bytes);
+        return;
+    }
+#endif
+    std::free(samples);
+}
+
+std::shared_ptr<SampleBuffer> SampleBuffer::allocate(size_t count, BufferPlacement placement) {
+    if (count <= 8) return allocateInline<8>(count);
+    if (count <= 16) return allocateInline<16>(count);
+    if (count <= 32) return allocateInline<32>(count);
+    if (count <= SAMPLE_BUFFER_INLINE_MAX) return allocateInline<SAMPLE_BUFFER_INLINE_MAX>(count);
+
+    std::shared_ptr<SampleBuffer> buffer(new SampleBuffer());
+    buffer->count = count;
+
+    const NumaTopology& topology = NumaTopology::instance();
+    size_t bytes = count * sizeof(int16_t);
+    bool interleaved = placement == BufferPlacement::Interleaved ||
+                       (placement == BufferPlacement::Automatic &&
+                        bytes >= interleave_threshold.load(std::memory_order_relaxed));
+
+#ifdef AUDIO_EDITOR_HAVE_MMAP
+    // Only worth the syscall overhead when the machine has several nodes
+    if (topology.isNuma() && bytes >= NUMA_PLACEMENT_MIN_BYTES) {
+        void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory != MAP_FAILED) {
+            buffer->samples = static_cast<int16_t*>(memory);
+            buffer->mapped_bytes = bytes;
+            if (interleaved && topology.interleave(memory, bytes)) {
+                buffer->numa_node = -1;
+            } else {
+                buffer->numa_node = topology.currentNode();
+                topology.preferNode(memory, bytes, buffer->numa_node);
+            }
+            return buffer;
+        }
+    }
+#endif
+
+    // Heap memory is zeroed by this thread, so first touch keeps it local
+    buffer->samples = static_cast<int16_t*>(std::calloc(count > 0 ? count : 1, sizeof(int16_t)));
+    if (!buffer->samples) {
+        throw std::bad_alloc();
+    }
+    buffer->numa_node = topology.currentNode();
+    return buffer;
+}
+
+std::shared_ptr<SampleBuffer> SampleBuffer::adopt(std::vector<int16_t>&& samples) {
+    return std::make_shared<VectorSampleBuffer>(std::move(samples));
+}
+
+std::shared_ptr<SampleBuffer> SampleBuffer::wrap(int16_t* samples, size_t count, Deleter deleter) {
+    std::shared_ptr<SampleBuffer> buffer(new SampleBuffer());
+    buffer->samples = samples;
+    buffer->count = count;
+    buffer->release = std::move(deleter);
+    buffer->numa_node = NumaTopology::instance().nodeOfAddress(samples);
+    return buffer;
+}
+
+void SampleBuffer::setInterleaveThreshold(size_t bytes) {
+    interleave_threshold.store(bytes, std::memory_order_relaxed);
+}
+
+}  // namespace AudioEditor
@@ -0,0 +1,93 @@
+#ifndef SAMPLE_BUFFER_HPP
+#define SAMPLE_BUFFER_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace AudioEditor {
+
+// Buffers at least this large are mapped directly so their pages can be placed
+constexpr size_t NUMA_PLACEMENT_MIN_BYTES = 256 * 1024;
+// Buffers at least this large are interleaved across nodes by default
+constexpr size_t NUMA_INTERLEAVE_MIN_BYTES = 256 * 1024 * 1024;
+// Buffers of up to this many samples live in the same allocation as their header
+constexpr size_t SAMPLE_BUFFER_INLINE_MAX = 64;
+
+/**
+ * Where the pages of a new buffer should live.
+ */
+enum class BufferPlacement {
+    Automatic,   // Local node, or interleaved when larger than the interleave threshold
+    LocalNode,   // Node of the allocating thread
+    Interleaved  // Spread across all nodes
+};
+
+/**
+ * Fixed-size, zero-initialised block of samples backing one or more segments.
+ * Large buffers are mapped from the OS and given a NUMA policy before their
+ * pages are touched; small ones come from the heap and are first-touch local.
+ * Tiny buffers (sample patches, crossfade joins) store their samples inline,
+ * next to the header and reference count, so they cost one allocation.
+ */
+class SampleBuffer {
+public:
+    // Releases memory handed to wrap()
+    using Deleter = std::function<void(int16_t*)>;
+
+private:
+    int16_t* samples;
+    size_t count;
+    size_t mapped_bytes;  // Non-zero when the memory came from mmap
+    int numa_node;        // Node requested at allocation, -1 if interleaved/unknown
+    std::atomic<bool> shared;  // Set once a snapshot references the buffer
+    bool inline_storage;       // Samples follow the header in the same allocation
+    Deleter release;           // Set for wrapped caller memory
+
+    SampleBuffer();
+
+    template <size_t N>
+    friend class InlineSampleBuffer;
+    friend class VectorSampleBuffer;
+
+public:
+    ~SampleBuffer();
+
+    SampleBuffer(const SampleBuffer&) = delete;
+    SampleBuffer& operator=(const SampleBuffer&) = delete;
+
+    static std::shared_ptr<SampleBuffer> allocate(size_t count,
+                                                  BufferPlacement placement = BufferPlacement::Automatic);
+
+    // Take over caller-owned samples without copying. adopt() keeps the
+    // vector inside the buffer; wrap() calls deleter when the last segment
+    // using the memory goes away.
+    static std::shared_ptr<SampleBuffer> adopt(std::vector<int16_t>&& samples);
+    static std::shared_ptr<SampleBuffer> wrap(int16_t* samples, size_t count, Deleter deleter);
+
+    int16_t* data() { return samples; }
+    const int16_t* data() const { return samples; }
+    size_t size() const { return count; }
+    bool isInline() const { return inline_storage; }
+    bool isMapped() const { return mapped_bytes > 0; }
+
+    int16_t& operator[](size_t index) { return samples[index]; }
+    const int16_t& operator[](size_t index) const { return samples[index]; }
+
+    // NUMA node holding the buffer (0 on single-node machines, -1 if interleaved)
+    int node() const { return numa_node; }
+
+    // Snapshots mark their buffers shared; shared buffers are never written again
+    void markShared() { shared.store(true, std::memory_order_release); }
+    bool isShared() const { return shared.load(std::memory_order_acquire); }
+
+    // Change the size above which Automatic placement interleaves
+    static void setInterleaveThreshold(size_t bytes);
+};
+
+}  // namespace AudioEditor
+
+#endif  // SAMPLE_BUFFER_HPP
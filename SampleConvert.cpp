@@ -0,0 +1,77 @@
+#include "SampleConvert.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace AudioEditor {
+
+namespace {
+
+#if defined(__SSE2__)
+// Sign-extend eight int16 samples into two vectors of int32
+inline void widen(const int16_t* src, __m128i& low, __m128i& high) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    low = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    high = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+}
+#endif
+
+}  // namespace
+
+void convertSamples(const int16_t* src, size_t count, float* dest, float scale, size_t stride) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128 factor = _mm_set1_ps(scale);
+    for (; count - i >= 8; i += 8) {
+        __m128i low, high;
+        widen(src + i, low, high);
+        __m128 f_low = _mm_mul_ps(_mm_cvtepi32_ps(low), factor);
+        __m128 f_high = _mm_mul_ps(_mm_cvtepi32_ps(high), factor);
+        if (stride == 1) {
+            _mm_storeu_ps(dest + i, f_low);
+            _mm_storeu_ps(dest + i + 4, f_high);
+        } else {
+            alignas(16) float staged[8];
+            _mm_store_ps(staged, f_low);
+            _mm_store_ps(staged + 4, f_high);
+            for (size_t k = 0; k < 8; ++k) {
+                dest[(i + k) * stride] = staged[k];
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        dest[i * stride] = static_cast<float>(src[i]) * scale;
+    }
+}
+
+void convertSamples(const int16_t* src, size_t count, int32_t* dest, int shift, size_t stride) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i amount = _mm_cvtsi32_si128(shift);
+    for (; count - i >= 8; i += 8) {
+        __m128i low, high;
+        widen(src + i, low, high);
+        low = _mm_sll_epi32(low, amount);
+        high = _mm_sll_epi32(high, amount);
+        if (stride == 1) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), low);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 4), high);
+        } else {
+            alignas(16) int32_t staged[8];
+            _mm_store_si128(reinterpret_cast<__m128i*>(staged), low);
+            _mm_store_si128(reinterpret_cast<__m128i*>(staged + 4), high);
+            for (size_t k = 0; k < 8; ++k) {
+                dest[(i + k) * stride] = staged[k];
+            }
+        }
+    }
+#endif
+    const int32_t factor = static_cast<int32_t>(1) << shift;
+    for (; i < count; ++i) {
+        dest[i * stride] = static_cast<int32_t>(src[i]) * factor;
+    }
+}
+
+}  // namespace AudioEditor
@@ -0,0 +1,29 @@
+#ifndef SAMPLE_CONVERT_HPP
+#define SAMPLE_CONVERT_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace AudioEditor {
+
+// Default scale for float reads: full-scale int16 maps to [-1, 1)
+constexpr float SAMPLE_FLOAT_SCALE = 1.0f / 32768.0f;
+
+// Default shift for int32 reads: int16 full scale becomes int32 full scale
+constexpr int SAMPLE_INT32_SHIFT = 16;
+
+/**
+ * Conversions applied while samples are copied out of segment memory.
+ * dest[i * stride] receives sample i, so one channel of an interleaved
+ * frame buffer can be filled by passing the channel's first slot and the
+ * channel count. Contiguous output uses SSE2 where available; strided
+ * output converts eight samples at a time and scatters them.
+ */
+void convertSamples(const int16_t* src, size_t count, float* dest, float scale, size_t stride);
+
+// dest[i * stride] = src[i] * 2^shift, shift in [0, 16]
+void convertSamples(const int16_t* src, size_t count, int32_t* dest, int shift, size_t stride);
+
+}  // namespace AudioEditor
+
+#endif  // SAMPLE_CONVERT_HPP
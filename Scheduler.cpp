@@ -0,0 +1,207 @@
+#include "Scheduler.hpp"
+#include "Numa.hpp"
+#include "ScratchArena.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+
+namespace AudioEditor {
+
+namespace {
+
+thread_local int worker_node = -1;
+
+}  // namespace
+
+Scheduler::Scheduler(size_t num_threads) : stopping(false) {
+    if (num_threads == 0) {
+        num_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    const NumaTopology& topology = NumaTopology::instance();
+    size_t nodes = topology.nodeCount();
+    node_queues.resize(nodes);
+    idle_workers.assign(nodes, 0);
+
+    // Idle workers hold their last task's scratch memory; wake them so they
+    // release it under memory pressure instead of at their next task
+    trim_listener = ScratchArena::addTrimListener([this]() {
+        { std::lock_guard<std::mutex> lock(queue_mutex); }
+        queue_cv.notify_all();
+    });
+
+    // Round-robin workers over nodes so every node gets local workers
+    workers.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers.emplace_back(&Scheduler::workerLoop, this, static_cast<int>(i % nodes));
+    }
+}
+
+Scheduler::~Scheduler() {
+    ScratchArena::removeTrimListener(trim_listener);
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stopping = true;
+    }
+    queue_cv.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+bool Scheduler::takeTask(int node, Task& task) {
+    // Local work first, then unplaced work
+    auto& local = node_queues[node];
+    if (!local.empty()) {
+        task = std::move(local.front());
+        local.pop_front();
+        return true;
+    }
+    if (!shared_queue.empty()) {
+        task = std::move(shared_queue.front());
+        shared_queue.pop_front();
+        return true;
+    }
+
+    // Help another node only when none of its own workers are free
+    for (size_t other = 0; other < node_queues.size(); ++other) {
+        if (!node_queues[other].empty() && idle_workers[other] == 0) {
+            task = std::move(node_queues[other].front());
+            node_queues[other].pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void Scheduler::workerLoop(int node) {
+    worker_node = node;
+    NumaTopology::instance().pinCurrentThread(node);
+    ScratchArena& arena = ScratchArena::local();
+
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            ++idle_workers[node];
+            for (;;) {
+                queue_cv.wait(lock, [this, node, &task, &arena] {
+                    return arena.trimPending() || takeTask(node, task) || stopping;
+                });
+                if (task || stopping) {
+                    break;
+                }
+
+                // No scope is open between tasks, so the arena can go now
+                lock.unlock();
+                arena.reset();
+                lock.lock();
+            }
+            --idle_workers[node];
+
+            // Drain remaining work before shutting down
+            if (!task) {
+                return;
+            }
+        }
+
+        // This worker is now busy, which may allow other nodes to steal
+        if (node_queues.size() > 1) {
+            queue_cv.notify_all();
+        }
+        task();
+    }
+}
+
+void Scheduler::submit(Task task, int node) {
+    if (!task) return;
+
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (stopping) {
+            throw std::runtime_error("Scheduler is shutting down");
+        }
+        if (node >= 0 && static_cast<size_t>(node) < node_queues.size()) {
+            node_queues[node].push_back(std::move(task));
+        } else {
+            shared_queue.push_back(std::move(task));
+        }
+    }
+
+    // With several nodes the woken worker must be one that may take the task
+    if (node_queues.size() > 1) {
+        queue_cv.notify_all();
+    } else {
+        queue_cv.notify_one();
+    }
+}
+
+void Scheduler::parallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) return;
+
+    struct Loop {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> finished{0};
+        size_t count = 0;
+        const std::function<void(size_t)>* body = nullptr;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    };
+    auto loop = std::make_shared<Loop>();
+    loop->count = count;
+    loop->body = &body;
+
+    // body is only touched after claiming an index, and the caller waits for
+    // every claimed index, so helpers that start late never see it dangle
+    auto drain = [loop]() {
+        for (;;) {
+            size_t i = loop->next.fetch_add(1);
+            if (i >= loop->count) return;
+            try {
+                (*loop->body)(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(loop->mutex);
+                if (!loop->error) loop->error = std::current_exception();
+            }
+            if (loop->finished.fetch_add(1) + 1 == loop->count) {
+                { std::lock_guard<std::mutex> lock(loop->mutex); }
+                loop->done.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min(count - 1, workers.size());
+    for (size_t i = 0; i < helpers; ++i) {
+        submit(drain);
+    }
+    drain();
+
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->done.wait(lock, [&loop] { return loop->finished.load() == loop->count; });
+    if (loop->error) {
+        std::rethrow_exception(loop->error);
+    }
+}
+
+size_t Scheduler::workerCount() const {
+    return workers.size();
+}
+
+size_t Scheduler::nodeCount() const {
+    return node_queues.size();
+}
+
+int Scheduler::currentWorkerNode() {
+    return worker_node;
+}
+
+Scheduler& Scheduler::instance() {
+    static Scheduler scheduler;
+    return scheduler;
+}
+
+}  // namespace AudioEditor
@@ -0,0 +1,71 @@
+#ifndef SCHEDULER_HPP
+#define SCHEDULER_HPP
+
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace AudioEditor {
+
+/**
+ * Fixed-size worker pool used by the library to run offloaded work
+ * (async I/O, identify, batched DSP).
+ *
+ * Workers are spread across NUMA nodes and pinned to their node's CPUs.
+ * Tasks submitted with a node hint go to that node's queue and are only
+ * taken by other nodes' workers when every local worker is busy. On a
+ * single-node machine this degenerates to one FIFO queue.
+ */
+class Scheduler {
+public:
+    using Task = std::function<void()>;
+
+private:
+    std::vector<std::thread> workers;
+    std::vector<std::deque<Task>> node_queues;  // One queue per NUMA node
+    std::deque<Task> shared_queue;              // Tasks without a placement hint
+    std::vector<size_t> idle_workers;           // Idle worker count per node
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    bool stopping;
+    size_t trim_listener;                       // Wakes idle workers to free scratch memory
+
+    void workerLoop(int node);
+    bool takeTask(int node, Task& task);
+
+public:
+    // num_threads == 0 selects std::thread::hardware_concurrency()
+    explicit Scheduler(size_t num_threads = 0);
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    // Queue a task; node >= 0 prefers workers on that NUMA node
+    void submit(Task task, int node = -1);
+
+    /**
+     * Run body(0) .. body(count - 1) on the workers and the calling thread,
+     * returning once every call has finished. The caller works through the
+     * indices too, so this is safe from inside a task on this scheduler.
+     * The first exception thrown by body is rethrown here.
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    size_t workerCount() const;
+    size_t nodeCount() const;
+
+    // NUMA node of the calling scheduler worker, or -1 on other threads
+    static int currentWorkerNode();
+
+    // Process-wide scheduler used when callers do not supply their own
+    static Scheduler& instance();
+};
+
+}  // namespace AudioEditor
+
+#endif  // SCHEDULER_HPP
@@ -0,0 +1,172 @@
+#include "ScratchArena.hpp"
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+namespace AudioEditor {
+
+namespace {
+
+std::atomic<unsigned> requested_trim_generation(0);
+
+struct TrimListeners {
+    std::mutex mutex;
+    std::map<size_t, std::function<void()>> entries;
+    size_t next_id = 1;
+};
+
+TrimListeners& trimListeners() {
+    static TrimListeners listeners;
+    return listeners;
+}
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}  // namespace
+
+ScratchArena::ScratchArena()
+    : current(0), peak_bytes(0), block_allocations(0),
+      trim_generation(requested_trim_generation.load(std::memory_order_relaxed)) {
+}
+
+void ScratchArena::addBlock(size_t min_bytes) {
+    size_t last = blocks.empty() ? SCRATCH_INITIAL_BLOCK_SIZE / 2 : blocks.back().size;
+    size_t size = std::max(last * 2, alignUp(min_bytes + SCRATCH_ALIGNMENT, SCRATCH_ALIGNMENT));
+
+    Block block;
+    block.memory.reset(new unsigned char[size]);
+    block.size = size;
+    block.used = 0;
+    blocks.push_back(std::move(block));
+    ++block_allocations;
+}
+
+size_t ScratchArena::bytesInUse() const {
+    size_t total = 0;
+    for (size_t i = 0; i <= current && i < blocks.size(); ++i) {
+        total += blocks[i].used;
+    }
+    return total;
+}
+
+void* ScratchArena::allocate(size_t bytes) {
+    if (bytes == 0) bytes = 1;
+
+    while (current < blocks.size()) {
+        Block& block = blocks[current];
+        uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+        size_t start = alignUp(base + block.used, SCRATCH_ALIGNMENT) - base;
+        if (start + bytes <= block.size) {
+            block.used = start + bytes;
+            peak_bytes = std::max(peak_bytes, bytesInUse());
+            return block.memory.get() + start;
+        }
+
+        // Move on to the next retained block, if any
+        if (current + 1 < blocks.size()) {
+            blocks[++current].used = 0;
+        } else {
+            break;
+        }
+    }
+
+    addBlock(bytes);
+    current = blocks.size() - 1;
+    return allocate(bytes);
+}
+
+ScratchArena::Marker ScratchArena::mark() const {
+    Marker marker;
+    marker.block = current;
+    marker.used = blocks.empty() ? 0 : blocks[current].used;
+    return marker;
+}
+
+void ScratchArena::rewind(const Marker& marker) {
+    if (marker.block == 0 && marker.used == 0) {
+        reset();
+        return;
+    }
+    current = marker.block;
+    if (current < blocks.size()) {
+        blocks[current].used = marker.used;
+    }
+}
+
+void ScratchArena::reset() {
+    unsigned requested = requested_trim_generation.load(std::memory_order_relaxed);
+    if (requested != trim_generation) {
+        trim_generation = requested;
+        release();
+        return;
+    }
+
+    // Several blocks means the last operation overflowed: replace them with
+    // one block sized for the peak so the next run fits without allocating
+    size_t wanted = alignUp(peak_bytes + blocks.size() * SCRATCH_ALIGNMENT, SCRATCH_ALIGNMENT);
+    if (wanted > SCRATCH_MAX_RETAINED_SIZE || capacity() > SCRATCH_MAX_RETAINED_SIZE) {
+        release();
+        return;
+    }
+    if (blocks.size() > 1) {
+        blocks.clear();
+        addBlock(wanted);
+    }
+    for (auto& block : blocks) {
+        block.used = 0;
+    }
+    current = 0;
+    peak_bytes = 0;
+}
+
+void ScratchArena::release() {
+    blocks.clear();
+    current = 0;
+    peak_bytes = 0;
+}
+
+size_t ScratchArena::capacity() const {
+    size_t total = 0;
+    for (const auto& block : blocks) {
+        total += block.size;
+    }
+    return total;
+}
+
+bool ScratchArena::trimPending() const {
+    return requested_trim_generation.load(std::memory_order_relaxed) != trim_generation;
+}
+
+void ScratchArena::requestTrim() {
+    requested_trim_generation.fetch_add(1, std::memory_order_relaxed);
+
+    // Held while notifying so a listener cannot be removed mid-call
+    TrimListeners& listeners = trimListeners();
+    std::lock_guard<std::mutex> lock(listeners.mutex);
+    for (auto& entry : listeners.entries) {
+        entry.second();
+    }
+}
+
+size_t ScratchArena::addTrimListener(std::function<void()> listener) {
+    TrimListeners& listeners = trimListeners();
+    std::lock_guard<std::mutex> lock(listeners.mutex);
+    size_t id = listeners.next_id++;
+    listeners.entries[id] = std::move(listener);
+    return id;
+}
+
+void ScratchArena::removeTrimListener(size_t id) {
+    TrimListeners& listeners = trimListeners();
+    std::lock_guard<std::mutex> lock(listeners.mutex);
+    listeners.entries.erase(id);
+}
+
+ScratchArena& ScratchArena::local() {
+    static thread_local ScratchArena arena;
+    return arena;
+}
+
+}  // namespace AudioEditor
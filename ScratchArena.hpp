@@ -0,0 +1,116 @@
+#ifndef SCRATCH_ARENA_HPP
+#define SCRATCH_ARENA_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace AudioEditor {
+
+constexpr size_t SCRATCH_INITIAL_BLOCK_SIZE = 64 * 1024;
+constexpr size_t SCRATCH_ALIGNMENT = 64;
+constexpr size_t SCRATCH_MAX_RETAINED_SIZE = 4 * 1024 * 1024;  // Larger peaks are freed on reset
+
+/**
+ * Per-thread bump allocator for temporary buffers (correlation windows, I/O
+ * staging, DSP scratch). Memory is released by rewinding to a marker, never
+ * per allocation. When an operation overflows the first block, the arena
+ * grows to a single block large enough for the peak, so steady-state work
+ * performs no heap allocations. Peaks above SCRATCH_MAX_RETAINED_SIZE are
+ * not kept: a one-off pass over a long track would otherwise pin its size
+ * on every thread that ran it.
+ */
+class ScratchArena {
+public:
+    struct Marker {
+        size_t block;
+        size_t used;
+    };
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> memory;
+        size_t size;
+        size_t used;
+    };
+
+    std::vector<Block> blocks;
+    size_t current;            // Index of the block currently being bumped
+    size_t peak_bytes;         // Largest total usage seen since the last reset
+    size_t block_allocations;  // Heap allocations performed by this arena
+    unsigned trim_generation;  // Last trim request this arena has honoured
+
+    void addBlock(size_t min_bytes);
+    size_t bytesInUse() const;
+
+public:
+    ScratchArena();
+    ~ScratchArena() = default;
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    // Uninitialised storage, aligned to SCRATCH_ALIGNMENT
+    void* allocate(size_t bytes);
+
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T)));
+    }
+
+    Marker mark() const;
+    void rewind(const Marker& marker);
+
+    // Rewind everything; consolidates overflow blocks into one, or frees all
+    // blocks if a trim was requested since the last reset or the peak was
+    // too large to keep
+    void reset();
+
+    // Drop retained memory (used under memory pressure); must not be in use
+    void release();
+
+    size_t capacity() const;
+    size_t blockAllocations() const { return block_allocations; }
+
+    // A trim was requested that the next reset will honour
+    bool trimPending() const;
+
+    // The calling thread's arena
+    static ScratchArena& local();
+
+    // Ask every thread's arena to free its memory at its next reset, and
+    // tell the listeners so threads parked between operations can reset now
+    static void requestTrim();
+
+    static size_t addTrimListener(std::function<void()> listener);
+    static void removeTrimListener(size_t id);
+};
+
+/**
+ * RAII scope that rewinds the thread's arena when an operation finishes.
+ * The outermost scope resets the arena entirely.
+ */
+class ScratchScope {
+private:
+    ScratchArena& arena;
+    ScratchArena::Marker marker;
+
+public:
+    explicit ScratchScope(ScratchArena& a = ScratchArena::local()) : arena(a), marker(a.mark()) {}
+    ~ScratchScope() { arena.rewind(marker); }
+
+    ScratchScope(const ScratchScope&) = delete;
+    ScratchScope& operator=(const ScratchScope&) = delete;
+
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return arena.allocateArray<T>(count);
+    }
+};
+
+}  // namespace AudioEditor
+
+#endif  // SCRATCH_ARENA_HPP
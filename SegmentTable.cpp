@@ -0,0 +1,163 @@
+#include "SegmentTable.hpp"
+#include "SoundSegment.hpp"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+namespace AudioEditor {
+
+namespace {
+
+std::mutex registry_mutex;
+std::vector<std::weak_ptr<SegmentTableCache>> registry;
+
+}  // namespace
+
+// ========== SegmentTable Implementation ==========
+
+std::shared_ptr<const SegmentTable> SegmentTable::build(const std::shared_ptr<SegmentNode>& head,
+                                                        std::vector<Marker> markers) {
+    auto table = std::make_shared<SegmentTable>();
+    table->markers = std::move(markers);
+    std::unordered_map<const SampleBuffer*, uint32_t> ids;
+
+    size_t global_pos = 0;
+    for (auto current = head; current; current = current->next) {
+        if (current->length == 0) continue;
+
+        auto found = ids.find(current->data.get());
+        uint32_t id;
+        if (found == ids.end()) {
+            id = static_cast<uint32_t>(table->buffers.size());
+            ids[current->data.get()] = id;
+            table->buffers.push_back(current->data);
+        } else {
+            id = found->second;
+        }
+
+        uint32_t flags = current->flags;
+        if (current->data->isShared()) {
+            flags |= SEGMENT_SHARED;
+        }
+
+        table->starts.push_back(global_pos);
+        table->segments.push_back(SegmentDescriptor{id, current->offset, current->length, flags});
+        global_pos += current->length;
+    }
+    table->starts.push_back(global_pos);
+
+    return table;
+}
+
+size_t SegmentTable::find(size_t pos) const {
+    if (pos >= totalLength()) {
+        return segmentCount();
+    }
+    // First start greater than pos, minus one; the sentinel bounds the search
+    auto it = std::upper_bound(starts.begin(), starts.end(), pos);
+    return static_cast<size_t>(it - starts.begin()) - 1;
+}
+
+size_t SegmentTable::copyOut(int16_t* dest, size_t start, size_t len) const {
+    size_t copied = 0;
+    scan(start, len, [&](const int16_t* samples, size_t count) {
+        std::memcpy(dest + copied, samples, count * sizeof(int16_t));
+        copied += count;
+    });
+    return copied;
+}
+
+size_t SegmentTable::copyIn(const int16_t* src, size_t start, size_t len) const {
+    size_t index = find(start);
+    size_t written = 0;
+    size_t pos = start;
+
+    while (index < segmentCount() && written < len) {
+        const SegmentDescriptor& segment = segments[index];
+        size_t local = pos - starts[index];
+        size_t count = std::min(segment.length - local, len - written);
+        int16_t* target = buffers[segment.buffer]->data() + segment.offset + local;
+        std::memcpy(target, src + written, count * sizeof(int16_t));
+        written += count;
+        pos += count;
+        ++index;
+    }
+    return written;
+}
+
+void SegmentTable::scan(size_t start, size_t len, const SpanVisitor& visit) const {
+    size_t index = find(start);
+    size_t remaining = len;
+    size_t pos = start;
+
+    while (index < segmentCount() && remaining > 0) {
+        const SegmentDescriptor& segment = segments[index];
+        size_t local = pos - starts[index];
+        size_t count = std::min(segment.length - local, remaining);
+        visit(buffers[segment.buffer]->data() + segment.offset + local, count);
+        remaining -= count;
+        pos += count;
+        ++index;
+    }
+}
+
+bool SegmentTable::isShared(size_t start, size_t len) const {
+    size_t index = find(start);
+    size_t remaining = len;
+    size_t pos = start;
+
+    while (index < segmentCount() && remaining > 0) {
+        // The flag is a build-time copy; a buffer shared since then (by a
+        // split or concat racing the build) is caught by the live bit
+        if ((segments[index].flags & SEGMENT_SHARED) || buffers[segments[index].buffer]->isShared()) {
+            return true;
+        }
+        size_t count = std::min(starts[index + 1] - pos, remaining);
+        remaining -= count;
+        pos += count;
+        ++index;
+    }
+    return false;
+}
+
+size_t SegmentTable::memoryBytes() const {
+    return sizeof(*this) +
+           starts.capacity() * sizeof(size_t) +
+           segments.capacity() * sizeof(SegmentDescriptor) +
+           buffers.capacity() * sizeof(std::shared_ptr<SampleBuffer>) +
+           markers.capacity() * sizeof(Marker);
+}
+
+// ========== SegmentTableCache Implementation ==========
+
+void SegmentTableCache::set(std::shared_ptr<const SegmentTable> fresh) {
+    // Register for trimming the first time this cache holds a table
+    if (!registered.exchange(true)) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.push_back(shared_from_this());
+    }
+    std::atomic_store(&table, std::move(fresh));
+}
+
+size_t SegmentTableCache::trimAll() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+
+    size_t released = 0;
+    size_t kept = 0;
+    for (auto& weak : registry) {
+        auto cache = weak.lock();
+        if (!cache) continue;
+
+        auto current = cache->get();
+        if (current) {
+            released += current->memoryBytes();
+            cache->clear();
+        }
+        registry[kept++] = weak;
+    }
+    registry.resize(kept);
+    return released;
+}
+
+}  // namespace AudioEditor
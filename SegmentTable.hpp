@@ -0,0 +1,106 @@
+#ifndef SEGMENT_TABLE_HPP
+#define SEGMENT_TABLE_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "MarkerIndex.hpp"
+#include "SampleBuffer.hpp"
+
+namespace AudioEditor {
+
+class SegmentNode;
+
+// A read that walks past this many list nodes asks for the table to be rebuilt
+constexpr size_t SEGMENT_TABLE_REBUILD_WALK = 32;
+
+// Offsets and lengths are 32-bit; longer runs of samples use several segments
+constexpr size_t SEGMENT_MAX_LENGTH = UINT32_MAX;
+
+// Segment flag bits, used by SegmentNode and SegmentDescriptor
+constexpr uint32_t SEGMENT_BUFFER_OWNER = 1u << 0;  // Segment allocated its buffer
+constexpr uint32_t SEGMENT_SHARED = 1u << 1;        // Buffer is referenced by a snapshot
+
+/**
+ * One segment of a SegmentTable, packed into 16 bytes: the buffer is an
+ * index into the table's buffer list rather than a shared_ptr.
+ */
+struct SegmentDescriptor {
+    uint32_t buffer;  // Index into SegmentTable::buffers
+    uint32_t offset;  // First sample within the buffer
+    uint32_t length;  // Number of samples
+    uint32_t flags;   // SEGMENT_* bits
+};
+
+static_assert(sizeof(SegmentDescriptor) == 16, "SegmentDescriptor must stay 16 bytes");
+
+/**
+ * Read-optimised, structure-of-arrays snapshot of a track's segment list.
+ * Segment i covers global samples [starts[i], starts[i + 1]) and is
+ * described by segments[i]. Lookups binary-search the contiguous starts
+ * array and scans then walk the descriptors sequentially, so no list
+ * pointers are chased. Built from the linked list and never modified, so a
+ * table is also a cheap, immutable snapshot of the track (24 bytes per
+ * segment plus one pointer per distinct buffer).
+ */
+class SegmentTable {
+public:
+    using SpanVisitor = std::function<void(const int16_t* samples, size_t count)>;
+
+    std::vector<size_t> starts;                 // Cumulative starts, plus total length as a sentinel
+    std::vector<SegmentDescriptor> segments;    // One descriptor per segment
+    std::vector<std::shared_ptr<SampleBuffer>> buffers;  // Distinct buffers, keeps them alive
+    std::vector<Marker> markers;                // Track markers, captured by snapshots only
+
+    static std::shared_ptr<const SegmentTable> build(const std::shared_ptr<SegmentNode>& head,
+                                                     std::vector<Marker> markers = {});
+
+    size_t segmentCount() const { return segments.size(); }
+    size_t totalLength() const { return starts.empty() ? 0 : starts.back(); }
+
+    // Index of the segment containing pos, or segmentCount() if pos is past the end
+    size_t find(size_t pos) const;
+
+    // Copy samples out of / into the track; ranges are clipped to the track
+    size_t copyOut(int16_t* dest, size_t start, size_t len) const;
+    size_t copyIn(const int16_t* src, size_t start, size_t len) const;
+
+    // True if any segment overlapping [start, start + len) is shared with a snapshot
+    bool isShared(size_t start, size_t len) const;
+
+    // Call visit once per contiguous run of samples in [start, start + len)
+    void scan(size_t start, size_t len, const SpanVisitor& visit) const;
+
+    // Approximate heap footprint of the table itself
+    size_t memoryBytes() const;
+};
+
+/**
+ * Holder for a track's current SegmentTable. Loads and stores are atomic so
+ * readers on one thread can use a table while another thread invalidates
+ * it. Every cache that has held a table can be emptied at once with
+ * trimAll(), which the memory-pressure monitor uses.
+ */
+class SegmentTableCache : public std::enable_shared_from_this<SegmentTableCache> {
+private:
+    std::shared_ptr<const SegmentTable> table;
+    std::atomic<bool> registered;
+
+public:
+    SegmentTableCache() : registered(false) {}
+
+    std::shared_ptr<const SegmentTable> get() const { return std::atomic_load(&table); }
+    void set(std::shared_ptr<const SegmentTable> fresh);
+    void clear() { std::atomic_store(&table, std::shared_ptr<const SegmentTable>()); }
+
+    // Drop every cached table; returns the bytes they occupied
+    static size_t trimAll();
+};
+
+}  // namespace AudioEditor
+
+#endif  // SEGMENT_TABLE_HPP
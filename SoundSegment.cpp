@@ -1,89 +1,109 @@
 #include "SoundSegment.hpp"
+#include "Numa.hpp"
+#include "ScratchArena.hpp"
+#include "TrackBuilder.hpp"
 #include <iostream>
 #include <fstream>
-#include <string.h>
+#include <cstring>
 #include <algorithm>
 #include <sstream>
 #include <stdexcept>
 #include <cmath>
+#include <cstdio>
 
 namespace AudioEditor {
 
-// ========== SegmentNode Implementation ==========
+namespace {
 
-SegmentNode::SegmentNode() 
-    : offset(0), length(0), global_start(0), is_buffer_owner(false) {
+// End of [start, start + len) for lock purposes, saturating instead of wrapping
+size_t rangeEnd(size_t start, size_t len) {
+    return len > RANGE_LOCK_END - start ? RANGE_LOCK_END : start + len;
 }
 
-SegmentNode::SegmentNode(std::shared_ptr<std::vector<int16_t>> data_ptr, size_t offset, size_t len)
-    : data(data_ptr), offset(offset), length(len), global_start(0), is_buffer_owner(false) {
-}
+}  // namespace
 
-void SegmentNode::addChild(std::shared_ptr<SegmentNode> child) {
-    if (!child) return;
-    children.push_back(std::weak_ptr<SegmentNode>(child));
+// ========== SegmentNode Implementation ==========
+
+SegmentNode::SegmentNode() 
+    : global_start(0), offset(0), length(0), flags(0) {
 }
 
-void SegmentNode::addParent(std::shared_ptr<SegmentNode> parent) {
-    if (!parent) return;
-    parents.push_back(std::weak_ptr<SegmentNode>(parent));
+SegmentNode::SegmentNode(std::shared_ptr<SampleBuffer> data_ptr, size_t offset, size_t len)
+    : data(data_ptr), global_start(0), offset(static_cast<uint32_t>(offset)),
+      length(static_cast<uint32_t>(len)), flags(0) {
+    // The narrowing above would silently wrap; callers split larger spans
+    if (offset > SEGMENT_MAX_LENGTH || len > SEGMENT_MAX_LENGTH) {
+        throw std::runtime_error("Segment offset or length exceeds the maximum segment length");
+    }
 }
 
-bool SegmentNode::hasActiveChildren() const {
-    for (const auto& weak_child : children) {
-        if (!weak_child.expired()) {
-            return true;
-        }
+SegmentNode::~SegmentNode() {
+    // Free each solely owned successor here instead of from its
+    // predecessor's destructor; a node still referenced elsewhere (a split
+    // point, a chain tail held by a caller) just loses this reference
+    std::shared_ptr<SegmentNode> rest = std::move(next);
+    while (rest && rest.use_count() == 1) {
+        std::shared_ptr<SegmentNode> following = std::move(rest->next);
+        rest = std::move(following);
     }
-    return false;
 }
 
 // ========== WavIO Implementation ==========
 
 std::vector<int16_t> WavIO::load(const std::string& filename) {
+    return load(filename, OperationControl::unbounded());
+}
+
+std::vector<int16_t> WavIO::load(const std::string& filename, const OperationControl& control) {
     std::ifstream file(filename, std::ios::binary);
     if (!file) {
         throw std::runtime_error("Cannot open file: " + filename);
     }
 
-    // Skip WAV header
-    file.seekg(WAV_HEADER_SIZE);
-    
     // Get file size
     file.seekg(0, std::ios::end);
     size_t file_size = file.tellg();
+    if (file_size < WAV_HEADER_SIZE) {
+        throw std::runtime_error("File too small to be a WAV file: " + filename);
+    }
+
+    // Skip WAV header
     file.seekg(WAV_HEADER_SIZE);
-    
+
     size_t data_size = file_size - WAV_HEADER_SIZE;
     size_t num_samples = data_size / BYTES_PER_SAMPLE;
-    
+
     std::vector<int16_t> samples(num_samples);
-    file.read(reinterpret_cast<char*>(samples.data()), data_size);
-    
-    if (!file) {
-        throw std::runtime_error("Error reading audio data from: " + filename);
+
+    // Read in blocks so cancellation and deadlines are honoured mid-file
+    size_t block = std::max<size_t>(control.block_size, 1);
+    size_t loaded = 0;
+    while (loaded < num_samples) {
+        control.checkpoint(loaded, num_samples);
+        size_t count = std::min(block, num_samples - loaded);
+        file.read(reinterpret_cast<char*>(samples.data() + loaded), count * BYTES_PER_SAMPLE);
+        if (!file) {
+            throw std::runtime_error("Error reading audio data from: " + filename);
+        }
+        loaded += count;
     }
-    
+    control.checkpoint(loaded, num_samples);
+
     return samples;
 }
 
-void WavIO::save(const std::string& filename, const std::vector<int16_t>& samples) {
-    std::ofstream file(filename, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("Cannot create file: " + filename);
-    }
-
-    uint32_t subchunk2_size = samples.size() * BYTES_PER_SAMPLE;
+void WavIO::writeHeader(std::ostream& file, size_t num_samples) {
+    uint32_t subchunk2_size = num_samples * BYTES_PER_SAMPLE;
     uint32_t chunk_size = 36 + subchunk2_size;
     uint32_t byte_rate = SAMPLE_RATE * NUM_CHANNELS * BITS_PER_SAMPLE / 8;
     uint16_t block_align = NUM_CHANNELS * BITS_PER_SAMPLE / 8;
+    uint32_t fmt_size = PCM_HEADER_SIZE;
 
-    // Write WAV header
     file.write("RIFF", 4);
     file.write(reinterpret_cast<const char*>(&chunk_size), 4);
     file.write("WAVE", 4);
     file.write("fmt ", 4);
-    file.write(reinterpret_cast<const char*>(&PCM_HEADER_SIZE), 4);
+    file.write(reinterpret_cast<const char*>(&fmt_size), 4);
     file.write(reinterpret_cast<const char*>(&PCM_FORMAT), 2);
     file.write(reinterpret_cast<const char*>(&NUM_CHANNELS), 2);
     file.write(reinterpret_cast<const char*>(&SAMPLE_RATE), 4);
@@ -92,10 +112,41 @@ void WavIO::save(const std::string& filename, const std::vector<int16_t>& sample
     file.write(reinterpret_cast<const char*>(&BITS_PER_SAMPLE), 2);
     file.write("data", 4);
     file.write(reinterpret_cast<const char*>(&subchunk2_size), 4);
+}
+
+void WavIO::save(const std::string& filename, const std::vector<int16_t>& samples) {
+    save(filename, samples, OperationControl::unbounded());
+}
+
+void WavIO::save(const std::string& filename, const std::vector<int16_t>& samples,
+                 const OperationControl& control) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot create file: " + filename);
+    }
+
+    // Write WAV header
+    writeHeader(file, samples.size());
+
+    // Write audio data block by block
+    size_t block = std::max<size_t>(control.block_size, 1);
+    size_t written = 0;
+    try {
+        while (written < samples.size()) {
+            control.checkpoint(written, samples.size());
+            size_t count = std::min(block, samples.size() - written);
+            file.write(reinterpret_cast<const char*>(samples.data() + written),
+                       count * BYTES_PER_SAMPLE);
+            written += count;
+        }
+        control.checkpoint(written, samples.size());
+    } catch (const OperationAborted&) {
+        // Do not leave a truncated WAV file behind
+        file.close();
+        std::remove(filename.c_str());
+        throw;
+    }
 
-    // Write audio data
-    file.write(reinterpret_cast<const char*>(samples.data()), subchunk2_size);
-    
     if (!file) {
         throw std::runtime_error("Error writing to file: " + filename);
     }
@@ -103,26 +154,56 @@ void WavIO::save(const std::string& filename, const std::vector<int16_t>& sample
 
 // ========== SoundSegment Implementation ==========
 
-SoundSegment::SoundSegment() : total_length(0) {
+SoundSegment::SoundSegment()
+    : total_length(0), locks(std::make_shared<RangeLockTable>()),
+      index(std::make_shared<SegmentTableCache>()), write_mode(WriteMode::InPlace), add_used(0),
+      coalesce_writes(false), pending(std::make_shared<WriteCoalescer>()),
+      marker_index(std::make_shared<MarkerIndex>()) {
 }
 
+// A moved-from track gets its own empty lock table, write buffer and
+// markers, so nothing done through it reaches the destination. It has no
+// index and never builds one.
 SoundSegment::SoundSegment(SoundSegment&& other) noexcept 
-    : head(std::move(other.head)), total_length(other.total_length) {
+    : head(std::move(other.head)), total_length(other.total_length.load()),
+      locks(std::move(other.locks)), index(std::move(other.index)), write_mode(other.write_mode.load()),
+      add_buffer(std::move(other.add_buffer)), add_used(other.add_used),
+      coalesce_writes(other.coalesce_writes.load()), pending(std::move(other.pending)),
+      marker_index(std::move(other.marker_index)) {
     other.total_length = 0;
+    other.add_used = 0;
+    other.locks = std::make_shared<RangeLockTable>();
+    other.pending = std::make_shared<WriteCoalescer>();
+    other.marker_index = std::make_shared<MarkerIndex>();
 }
 
 SoundSegment& SoundSegment::operator=(SoundSegment&& other) noexcept {
     if (this != &other) {
         head = std::move(other.head);
-        total_length = other.total_length;
+        total_length = other.total_length.load();
+        index = std::move(other.index);
+        write_mode = other.write_mode.load();
+        add_buffer = std::move(other.add_buffer);
+        add_used = other.add_used;
+        coalesce_writes = other.coalesce_writes.load();
+        pending = std::move(other.pending);
+        marker_index = std::move(other.marker_index);
         other.total_length = 0;
+        other.add_used = 0;
+        other.pending = std::make_shared<WriteCoalescer>();
+        other.marker_index = std::make_shared<MarkerIndex>();
     }
     return *this;
 }
 
 void SoundSegment::updateGlobalIndices() {
-    size_t global_pos = 0;
-    auto current = head;
+    reindexFrom(nullptr);
+}
+
+void SoundSegment::reindexFrom(std::shared_ptr<SegmentNode> prev) {
+    // Nodes up to and including prev are unchanged by the edit
+    size_t global_pos = prev ? prev->global_start + prev->length : 0;
+    auto current = prev ? prev->next : head;
     
     while (current) {
         current->global_start = global_pos;
@@ -133,6 +214,61 @@ void SoundSegment::updateGlobalIndices() {
     total_length = global_pos;
 }
 
+std::shared_ptr<const SegmentTable> SoundSegment::currentTable() const {
+    return index ? index->get() : nullptr;
+}
+
+void SoundSegment::invalidateIndex() {
+    if (index) index->clear();
+}
+
+void SoundSegment::tryRebuildIndex() const {
+    if (!index) return;
+
+    // Building needs a stable list; give up rather than wait for writers
+    size_t ticket = locks->tryAcquire(0, RANGE_LOCK_END, RangeLockMode::Shared);
+    if (ticket == 0) return;
+
+    RangeLock lock = RangeLock::adopt(*locks, ticket);
+    index->set(SegmentTable::build(head));
+}
+
+void SoundSegment::rebuildIndex() const {
+    if (!index) return;
+
+    RangeLock lock(*locks, 0, RANGE_LOCK_END, RangeLockMode::Shared);
+    index->set(SegmentTable::build(head));
+}
+
+bool SoundSegment::isIndexed() const {
+    return static_cast<bool>(currentTable());
+}
+
+RangeLock SoundSegment::lockStructure(size_t pos) const {
+    for (;;) {
+        size_t start = std::min(pos, total_length.load());
+        RangeLock lock(*locks, start, RANGE_LOCK_END, RangeLockMode::Exclusive);
+
+        // Edits before start are excluded now; retry if one shrank the track first
+        size_t len = total_length;
+        if (start > len) {
+            continue;
+        }
+
+        // The segment containing start (or the tail, when appending) is
+        // modified too, so extend the lock back to its first sample
+        size_t node_start = 0;
+        for (auto current = head; current; current = current->next) {
+            node_start = current->global_start;
+            if (start < current->global_start + current->length || !current->next) {
+                break;
+            }
+        }
+        lock.extendDown(std::min(node_start, start));
+        return lock;
+    }
+}
+
 std::shared_ptr<SegmentNode> SoundSegment::findSegmentAt(size_t pos, size_t& local_offset) const {
     auto current = head;
     
@@ -162,28 +298,399 @@ std::shared_ptr<SegmentNode> SoundSegment::splitNode(std::shared_ptr<SegmentNode
     return right;
 }
 
-std::shared_ptr<SegmentNode> SoundSegment::createSegment(std::shared_ptr<std::vector<int16_t>> data, 
+std::shared_ptr<SegmentNode> SoundSegment::createSegment(std::shared_ptr<SampleBuffer> data, 
                                                          size_t offset, size_t len) {
     auto node = std::make_shared<SegmentNode>(data, offset, len);
     return node;
 }
 
+std::shared_ptr<SegmentNode> SoundSegment::allocateSegments(size_t len, std::shared_ptr<SegmentNode>& tail) {
+    // Fresh zeroed storage, split so no segment exceeds the 32-bit limit
+    std::shared_ptr<SegmentNode> first;
+    tail = nullptr;
+    while (len > 0) {
+        size_t chunk = std::min(len, SEGMENT_MAX_LENGTH);
+        auto node = createSegment(SampleBuffer::allocate(chunk), 0, chunk);
+        node->flags |= SEGMENT_BUFFER_OWNER;
+        if (tail) {
+            node->global_start = tail->global_start + tail->length;
+            tail->next = node;
+        } else {
+            first = node;
+        }
+        tail = node;
+        len -= chunk;
+    }
+    return first;
+}
+
+bool SoundSegment::touchesShared(size_t pos, size_t len) const {
+    auto table = currentTable();
+    if (table) {
+        return table->isShared(pos, len);
+    }
+
+    // Stop at the node holding end - 1: later links may be edited concurrently
+    size_t end = rangeEnd(pos, len);
+    for (auto current = head; current; current = current->next) {
+        size_t node_end = current->global_start + current->length;
+        if (node_end > pos && current->data->isShared()) {
+            return true;
+        }
+        if (node_end >= end) {
+            break;
+        }
+    }
+    return false;
+}
+
+void SoundSegment::privatizeRange(size_t pos, size_t len) {
+    // Give [pos, pos + len) private copies wherever a snapshot shares the
+    // buffer. Copies cover whole COW blocks of the buffer, so later writes
+    // nearby land in the same private block. Callers hold the structural
+    // lock, which already covers the whole node containing pos.
+    size_t end = rangeEnd(pos, len);
+    for (auto current = head; current && current->global_start < end; current = current->next) {
+        size_t node_end = current->global_start + current->length;
+        if (node_end <= pos || !current->data->isShared()) {
+            continue;
+        }
+
+        // Widen the written part of the node to block boundaries in the buffer
+        size_t first = std::max(pos, current->global_start) - current->global_start + current->offset;
+        size_t last = std::min(end, node_end) - current->global_start + current->offset;
+        first = first / COW_BLOCK_SAMPLES * COW_BLOCK_SAMPLES;
+        last = (last + COW_BLOCK_SAMPLES - 1) / COW_BLOCK_SAMPLES * COW_BLOCK_SAMPLES;
+        size_t copy_start = current->global_start + (std::max<size_t>(first, current->offset) - current->offset);
+        size_t copy_end = current->global_start +
+                          (std::min<size_t>(last, current->offset + current->length) - current->offset);
+
+        if (copy_start > current->global_start) {
+            current = splitNode(current, copy_start - current->global_start);
+        }
+        if (copy_end < current->global_start + current->length) {
+            splitNode(current, copy_end - current->global_start);
+        }
+
+        auto copy = SampleBuffer::allocate(current->length);
+        std::memcpy(copy->data(), current->data->data() + current->offset,
+                    current->length * BYTES_PER_SAMPLE);
+        current->data = copy;
+        current->offset = 0;
+        current->flags |= SEGMENT_BUFFER_OWNER;
+    }
+}
+
+std::shared_ptr<SegmentNode> SoundSegment::boundaryAt(size_t pos) {
+    // Make pos a segment boundary and return the node ending there (null at
+    // the start of the track). Callers hold the structural lock.
+    std::shared_ptr<SegmentNode> prev;
+    for (auto current = head; current; prev = current, current = current->next) {
+        if (pos <= current->global_start) {
+            return prev;
+        }
+        if (pos < current->global_start + current->length) {
+            splitNode(current, pos - current->global_start);
+            return current;
+        }
+    }
+    return prev;
+}
+
+std::shared_ptr<SegmentNode> SoundSegment::appendPieces(const int16_t* src, size_t len,
+                                                        std::shared_ptr<SegmentNode>& tail) {
+    // Writes larger than a chunk get buffers of their own
+    if (len > PIECE_ADD_BUFFER_SAMPLES) {
+        auto first = allocateSegments(len, tail);
+        size_t copied = 0;
+        for (auto node = first; node; node = node->next) {
+            std::memcpy(node->data->data(), src + copied, node->length * BYTES_PER_SAMPLE);
+            copied += node->length;
+        }
+        return first;
+    }
+
+    // Only the unused tail of the add buffer is written, so pieces already
+    // handed out (and any snapshot sharing them) never change
+    if (!add_buffer || add_buffer->size() - add_used < len) {
+        add_buffer = SampleBuffer::allocate(PIECE_ADD_BUFFER_SAMPLES);
+        add_used = 0;
+    }
+    std::memcpy(add_buffer->data() + add_used, src, len * BYTES_PER_SAMPLE);
+    tail = createSegment(add_buffer, add_used, len);
+    add_used += len;
+    return tail;
+}
+
+void SoundSegment::writePieces(const int16_t* src, size_t pos, size_t len) {
+    std::shared_ptr<SegmentNode> tail;
+    auto pieces = appendPieces(src, len, tail);
+    replaceRange(pos, pieces, tail);
+}
+
+void SoundSegment::replaceRange(size_t pos, std::shared_ptr<SegmentNode> pieces,
+                                std::shared_ptr<SegmentNode> tail) {
+    // Overwrite [pos, pos + len) with the chain pieces..tail, where len is
+    // the chain's length. Callers hold the structural lock.
+    invalidateIndex();
+
+    size_t len = 0;
+    for (auto node = pieces; node; node = node->next) {
+        len += node->length;
+    }
+
+    // Writing past the end leaves silence in between, as in-place writes do
+    if (pos > total_length) {
+        std::shared_ptr<SegmentNode> gap_tail;
+        auto gap = allocateSegments(pos - total_length, gap_tail);
+        auto last = boundaryAt(total_length);
+        if (last) {
+            last->next = gap;
+        } else {
+            head = gap;
+        }
+        reindexFrom(last);
+    }
+
+    // Unlink the segments covering [pos, cut_end)
+    size_t cut_end = std::min(pos + len, total_length.load());
+    auto prev = boundaryAt(pos);
+    auto last_cut = boundaryAt(cut_end);
+    auto rest = cut_end > pos ? last_cut->next : (prev ? prev->next : head);
+
+    // Sequential writes extend the previous piece instead of adding one
+    if (prev && prev->data == pieces->data && prev->offset + prev->length == pieces->offset &&
+        prev->length + pieces->length <= SEGMENT_MAX_LENGTH) {
+        prev->length += pieces->length;
+        if (tail == pieces) {
+            tail = prev;
+        }
+        pieces = pieces->next;
+    }
+
+    if (pieces) {
+        if (prev) {
+            prev->next = pieces;
+        } else {
+            head = pieces;
+        }
+        tail->next = rest;
+    } else {
+        prev->next = rest;
+    }
+    reindexFrom(prev);
+}
+
+void SoundSegment::adopt(std::shared_ptr<SampleBuffer> buffer, size_t pos) {
+    if (!buffer || buffer->size() == 0) return;
+    if (buffer->size() > SEGMENT_MAX_LENGTH) {
+        throw std::runtime_error("Adopted buffer exceeds the maximum segment length");
+    }
+
+    if (coalesce_writes) {
+        flushOverlapping(pos, buffer->size());
+    }
+    RangeLock lock = lockStructure(pos);
+
+    auto node = createSegment(buffer, 0, buffer->size());
+    node->flags |= SEGMENT_BUFFER_OWNER;
+    replaceRange(pos, node, node);
+}
+
+void SoundSegment::adopt(std::vector<int16_t>&& samples, size_t pos) {
+    if (samples.empty()) return;
+
+    // A single segment cannot describe more than SEGMENT_MAX_LENGTH samples
+    if (samples.size() > SEGMENT_MAX_LENGTH) {
+        write(samples.data(), pos, samples.size());
+        return;
+    }
+    adopt(SampleBuffer::adopt(std::move(samples)), pos);
+}
+
+void SoundSegment::adopt(int16_t* samples, size_t count, SampleBuffer::Deleter deleter, size_t pos) {
+    if (!samples || count == 0) return;
+    adopt(SampleBuffer::wrap(samples, count, std::move(deleter)), pos);
+}
+
+void SoundSegment::setWriteMode(WriteMode mode) {
+    // Buffered writes were issued under the old mode
+    flushWrites();
+    write_mode = mode;
+}
+
+void SoundSegment::setWriteCoalescing(bool enabled) {
+    coalesce_writes = enabled;
+    if (!enabled) {
+        flushWrites();
+    }
+}
+
+size_t SoundSegment::pendingWrites() const {
+    return pending->runCount();
+}
+
+void SoundSegment::flushWrites() const {
+    auto flush = pending->lockFlush();
+    auto runs = pending->take();
+    if (runs.empty()) return;
+
+    // Buffered writes are already part of the track's logical contents;
+    // applying them changes representation only, so const readers may flush
+    try {
+        const_cast<SoundSegment*>(this)->applyRuns(runs);
+    } catch (...) {
+        pending->applied();
+        throw;
+    }
+    pending->applied();
+}
+
+void SoundSegment::flushOverlapping(size_t start_pos, size_t len) const {
+    if (pending->overlaps(start_pos, len)) {
+        flushWrites();
+    }
+}
+
+void SoundSegment::applyRuns(const std::vector<WriteCoalescer::Run>& runs) {
+    size_t first = runs.front().pos;
+    size_t last = runs.back().pos + runs.back().samples.size();
+
+    RangeLock lock(*locks, first, last, RangeLockMode::Exclusive);
+    if (write_mode == WriteMode::InPlace && last <= total_length && !touchesShared(first, last - first)) {
+        auto table = currentTable();
+        if (table) {
+            for (const auto& run : runs) {
+                table->copyIn(run.samples.data(), run.pos, run.samples.size());
+            }
+            return;
+        }
+
+        // Runs are sorted, so one walk down the list serves them all
+        auto current = head;
+        for (const auto& run : runs) {
+            size_t pos = run.pos;
+            size_t done = 0;
+            while (current && done < run.samples.size()) {
+                size_t node_end = current->global_start + current->length;
+                if (pos >= node_end) {
+                    current = current->next;
+                    continue;
+                }
+                size_t count = std::min(node_end - pos, run.samples.size() - done);
+                std::memcpy(current->data->data() + current->offset + (pos - current->global_start),
+                            run.samples.data() + done, count * BYTES_PER_SAMPLE);
+                done += count;
+                pos += count;
+            }
+        }
+        return;
+    }
+
+    // Copy-on-write and piece-table writes change segments; apply one by one
+    lock.unlock();
+    for (const auto& run : runs) {
+        writeNow(run.samples.data(), run.pos, run.samples.size());
+    }
+}
+
+WriteMode SoundSegment::writeMode() const {
+    return write_mode;
+}
+
 size_t SoundSegment::length() const {
     return total_length;
 }
 
 void SoundSegment::read(std::vector<int16_t>& dest, size_t start_pos, size_t len) const {
-    dest.resize(len);
-    read(dest.data(), start_pos, len);
+    flushOverlapping(start_pos, len);
+
+    RangeLock lock(*locks, start_pos, rangeEnd(start_pos, len), RangeLockMode::Shared);
+
+    // Only return samples that actually exist in the track
+    size_t available = start_pos < total_length ? std::min(len, total_length - start_pos) : 0;
+    dest.resize(available);
+    readUnlocked(dest.data(), start_pos, available);
 }
 
 void SoundSegment::read(int16_t* dest, size_t start_pos, size_t len) const {
     if (!dest) return;
 
+    flushOverlapping(start_pos, len);
+    RangeLock lock(*locks, start_pos, rangeEnd(start_pos, len), RangeLockMode::Shared);
+    readUnlocked(dest, start_pos, len);
+}
+
+void SoundSegment::read(float* dest, size_t start_pos, size_t len, float scale, size_t stride) const {
+    if (!dest) return;
+    if (stride == 0) {
+        throw std::runtime_error("Read stride must be at least 1");
+    }
+
+    size_t done = 0;
+    scan(start_pos, len, [&](const int16_t* samples, size_t count) {
+        convertSamples(samples, count, dest + done * stride, scale, stride);
+        done += count;
+    });
+}
+
+void SoundSegment::read(int32_t* dest, size_t start_pos, size_t len, int shift, size_t stride) const {
+    if (!dest) return;
+    if (stride == 0) {
+        throw std::runtime_error("Read stride must be at least 1");
+    }
+    if (shift < 0 || shift > 16) {
+        throw std::runtime_error("int32 read shift must be between 0 and 16");
+    }
+
+    size_t done = 0;
+    scan(start_pos, len, [&](const int16_t* samples, size_t count) {
+        convertSamples(samples, count, dest + done * stride, shift, stride);
+        done += count;
+    });
+}
+
+void SoundSegment::read(std::vector<float>& dest, size_t start_pos, size_t len, float scale) const {
+    size_t length_now = total_length;
+    dest.resize(start_pos < length_now ? std::min(len, length_now - start_pos) : 0);
+    read(dest.data(), start_pos, dest.size(), scale);
+}
+
+void SoundSegment::read(std::vector<int32_t>& dest, size_t start_pos, size_t len, int shift) const {
+    size_t length_now = total_length;
+    dest.resize(start_pos < length_now ? std::min(len, length_now - start_pos) : 0);
+    read(dest.data(), start_pos, dest.size(), shift);
+}
+
+void SoundSegment::readDecimated(std::vector<int16_t>& dest, size_t start_pos, size_t len, size_t factor,
+                                 DecimateMode mode) const {
+    size_t length_now = total_length;
+    size_t available = start_pos < length_now ? std::min(len, length_now - start_pos) : 0;
+    dest.resize(Decimator::outputsFor(available, factor, mode));
+
+    Decimator decimator(factor, mode, dest.data());
+    scan(start_pos, available, [&decimator](const int16_t* samples, size_t count) {
+        decimator.feed(samples, count);
+    });
+    decimator.finish();
+
+    // The track may have shrunk before scan locked it
+    dest.resize(decimator.outputCount());
+}
+
+void SoundSegment::readUnlocked(int16_t* dest, size_t start_pos, size_t len) const {
+    auto table = currentTable();
+    if (table) {
+        table->copyOut(dest, start_pos, len);
+        return;
+    }
+
     size_t samples_copied = 0;
+    size_t walked = 0;
     auto current = head;
 
     while (current && samples_copied < len) {
+        ++walked;
         if (start_pos >= current->global_start && 
             start_pos < current->global_start + current->length) {
             
@@ -199,7 +706,46 @@ void SoundSegment::read(int16_t* dest, size_t start_pos, size_t len) const {
             samples_copied += samples_to_copy;
             start_pos += samples_to_copy;
         }
-        current = current->next;
+        if (samples_copied < len) {
+            current = current->next;
+        }
+    }
+
+    // Long walks mean a fragmented list; index it for the next reader
+    if (walked > SEGMENT_TABLE_REBUILD_WALK) {
+        tryRebuildIndex();
+    }
+}
+
+void SoundSegment::scan(size_t start_pos, size_t len, const SegmentTable::SpanVisitor& visit) const {
+    flushOverlapping(start_pos, len);
+    RangeLock lock(*locks, start_pos, rangeEnd(start_pos, len), RangeLockMode::Shared);
+
+    auto table = currentTable();
+    if (!table) {
+        tryRebuildIndex();
+        table = currentTable();
+    }
+    if (table) {
+        table->scan(start_pos, len, visit);
+        return;
+    }
+
+    // No index (moved-from track, or a writer blocked the rebuild): walk the list
+    size_t remaining = len;
+    auto current = head;
+    while (current && remaining > 0) {
+        size_t node_end = current->global_start + current->length;
+        if (start_pos >= current->global_start && start_pos < node_end) {
+            size_t local = start_pos - current->global_start;
+            size_t count = std::min(node_end - start_pos, remaining);
+            visit(current->data->data() + current->offset + local, count);
+            remaining -= count;
+            start_pos += count;
+        }
+        if (remaining > 0) {
+            current = current->next;
+        }
     }
 }
 
@@ -210,36 +756,63 @@ void SoundSegment::write(const std::vector<int16_t>& src, size_t pos) {
 void SoundSegment::write(const int16_t* src, size_t pos, size_t len) {
     if (!src || len == 0) return;
 
+    if (coalesce_writes) {
+        if (len <= COALESCE_MAX_WRITE && len <= total_length && pos <= total_length - len) {
+            if (pending->add(src, pos, len) > COALESCE_MAX_PENDING) {
+                flushWrites();
+            }
+            return;
+        }
+        // Keep larger and extending writes ordered after the buffered ones
+        flushOverlapping(pos, len);
+    }
+    writeNow(src, pos, len);
+}
+
+void SoundSegment::writeNow(const int16_t* src, size_t pos, size_t len) {
+    if (write_mode == WriteMode::PieceTable) {
+        RangeLock lock = lockStructure(pos);
+        writePieces(src, pos, len);
+        return;
+    }
+
     size_t end_pos = pos + len;
 
-    // Extend track if necessary
+    // Overwrites inside the track only need the written range
+    RangeLock lock(*locks, pos, rangeEnd(pos, len), RangeLockMode::Exclusive);
+
+    // Extending the track, or replacing buffers a snapshot still uses,
+    // changes segments, so take a structural lock
+    bool structural = end_pos > total_length || touchesShared(pos, len);
+    if (structural) {
+        lock.unlock();
+        lock = lockStructure(pos);
+        invalidateIndex();
+        privatizeRange(pos, len);
+    }
+
     if (end_pos > total_length) {
-        auto last = head;
-
-        if (!last) {
-            // Create first node
-            auto data_buffer = std::make_shared<std::vector<int16_t>>(end_pos);
-            last = std::make_shared<SegmentNode>(data_buffer, 0, end_pos);
-            last->is_buffer_owner = true;
-            head = last;
+        std::shared_ptr<SegmentNode> new_tail;
+        auto new_nodes = allocateSegments(end_pos - total_length, new_tail);
+
+        std::shared_ptr<SegmentNode> last;
+        if (!head) {
+            head = new_nodes;
         } else {
             // Find last node
+            last = head;
             while (last->next) {
                 last = last->next;
             }
-
-            size_t last_end = last->global_start + last->length;
-            if (last_end < end_pos) {
-                size_t new_node_len = end_pos - last_end;
-                auto data_buffer = std::make_shared<std::vector<int16_t>>(new_node_len);
-                auto new_node = std::make_shared<SegmentNode>(data_buffer, 0, new_node_len);
-                new_node->global_start = last_end;
-                new_node->is_buffer_owner = true;
-                last->next = new_node;
-            }
+            last->next = new_nodes;
         }
+        reindexFrom(last);
+    }
 
-        updateGlobalIndices();
+    auto table = currentTable();
+    if (table) {
+        table->copyIn(src, pos, len);
+        return;
     }
 
     // Write data to appropriate segments
@@ -264,39 +837,28 @@ void SoundSegment::write(const int16_t* src, size_t pos, size_t len) {
             src_index += to_write;
             global_index += to_write;
         }
-        current = current->next;
+        if (remaining > 0) {
+            current = current->next;
+        }
     }
 }
 
 bool SoundSegment::deleteRange(size_t pos, size_t len) {
+    // Buffered writes refer to positions this edit is about to shift
+    flushWrites();
+    RangeLock lock = lockStructure(pos);
+
     if (pos + len > total_length) {
         return false;
     }
-
-    // First pass: check if any segments in range have children
-    size_t to_check = len;
-    size_t cur_pos = pos;
-    size_t local_off;
-    auto current = findSegmentAt(pos, local_off);
-
-    while (current && to_check > 0) {
-        if (current->hasActiveChildren()) {
-            return false;
-        }
-
-        size_t available = current->length - local_off;
-        if (to_check > available) {
-            to_check -= available;
-            current = current->next;
-            local_off = 0;
-        } else {
-            break;
-        }
+    if (len == 0) {
+        return true;
     }
+    invalidateIndex();
 
-    // Second pass: perform actual deletion
     size_t to_delete = len;
-    current = findSegmentAt(pos, local_off);
+    size_t local_off;
+    auto current = findSegmentAt(pos, local_off);
     std::shared_ptr<SegmentNode> prev = nullptr;
 
     // Find previous node if not at head
@@ -307,16 +869,33 @@ bool SoundSegment::deleteRange(size_t pos, size_t len) {
         }
     }
 
+    // Renumbering starts after the last node that keeps its position
+    auto unchanged = prev;
+
     while (to_delete > 0 && current) {
         size_t available = current->length - local_off;
 
-        if (to_delete < available) {
+        if (to_delete < available && !current->data->isShared()) {
             // Partial deletion within segment
             std::memmove(current->data->data() + current->offset + local_off,
                         current->data->data() + current->offset + local_off + to_delete,
                         (available - to_delete) * BYTES_PER_SAMPLE);
             current->length -= to_delete;
             to_delete = 0;
+        } else if (to_delete < available) {
+            // A snapshot still reads this buffer; cut the samples out by
+            // splitting the node instead of moving data
+            splitNode(current, local_off + to_delete);
+            current->length = local_off;
+            to_delete = 0;
+
+            if (current->length == 0) {
+                if (prev) {
+                    prev->next = current->next;
+                } else {
+                    head = current->next;
+                }
+            }
         } else {
             // Full deletion of segment or part of it
             to_delete -= available;
@@ -324,7 +903,6 @@ bool SoundSegment::deleteRange(size_t pos, size_t len) {
 
             if (current->length == 0) {
                 // Remove empty segment from linked list
-                auto temp = current;
                 if (prev) {
                     prev->next = current->next;
                 } else {
@@ -343,41 +921,86 @@ bool SoundSegment::deleteRange(size_t pos, size_t len) {
         }
     }
 
-    updateGlobalIndices();
+    reindexFrom(unchanged);
+    marker_index->onDelete(pos, len);
     return true;
 }
 
 std::string SoundSegment::identify(const SoundSegment& ad) const {
-    if (total_length == 0 || ad.total_length == 0 || total_length < ad.total_length) {
+    return identify(ad, OperationControl::unbounded());
+}
+
+std::string SoundSegment::identify(const SoundSegment& ad, const OperationControl& control) const {
+    return identifyIn(0, RANGE_LOCK_END, ad, control);
+}
+
+std::string SoundSegment::identifyIn(size_t start, size_t len, const SoundSegment& ad,
+                                     const OperationControl& control) const {
+    flushOverlapping(start, len);
+    ad.flushWrites();
+    size_t available = start < total_length ? std::min(len, total_length - start) : 0;
+    if (available == 0 || ad.total_length == 0 || available < ad.total_length) {
         return "";
     }
 
-    // Get all samples for simplicity (in production, could optimize this)
-    auto target_samples = getAllSamples();
-    auto ad_samples = ad.getAllSamples();
+    // Flatten both tracks into per-thread scratch memory; the scope returns
+    // it when identify finishes, so repeated calls do not touch the heap.
+    // Each track is only locked while it is being copied.
+    ScratchScope scratch;
+    int16_t* target_samples;
+    int16_t* ad_samples;
+    size_t target_len;
+    size_t ad_len;
+    {
+        RangeLock lock(*locks, start, rangeEnd(start, len), RangeLockMode::Shared);
+        target_len = start < total_length ? std::min(len, total_length - start) : 0;
+        target_samples = scratch.allocateArray<int16_t>(target_len);
+        readUnlocked(target_samples, start, target_len);
+    }
+    {
+        RangeLock lock(*ad.locks, 0, RANGE_LOCK_END, RangeLockMode::Shared);
+        ad_len = ad.total_length;
+        ad_samples = scratch.allocateArray<int16_t>(ad_len);
+        ad.readUnlocked(ad_samples, 0, ad_len);
+    }
+    if (ad_len == 0 || target_len < ad_len) {
+        return "";
+    }
 
     // Calculate auto-correlation reference value
     double auto_ref = 0.0;
-    for (size_t j = 0; j < ad_samples.size(); j++) {
+    for (size_t j = 0; j < ad_len; j++) {
         auto_ref += static_cast<double>(ad_samples[j]) * ad_samples[j];
     }
     double threshold = CORRELATION_THRESHOLD * auto_ref;
 
+    // Each candidate position costs ad_len multiply-adds, so check the
+    // control once per block_size worth of multiply-adds
+    size_t positions = target_len - ad_len + 1;
+    size_t check_every = std::max<size_t>(control.block_size / ad_len, 1);
+    size_t next_check = 0;
+
     std::vector<std::pair<size_t, size_t>> occurrences;
     size_t i = 0;
-    while (i <= target_samples.size() - ad_samples.size()) {
+    while (i <= target_len - ad_len) {
+        if (i >= next_check) {
+            control.checkpoint(i, positions);
+            next_check = i + check_every;
+        }
+
         double corr = 0.0;
-        for (size_t j = 0; j < ad_samples.size(); j++) {
+        for (size_t j = 0; j < ad_len; j++) {
             corr += static_cast<double>(target_samples[i + j]) * ad_samples[j];
         }
         
         if (corr >= threshold) {
-            occurrences.emplace_back(i, i + ad_samples.size() - 1);
-            i += ad_samples.size();  // Skip ahead to avoid overlapping matches
+            occurrences.emplace_back(i, i + ad_len - 1);
+            i += ad_len;  // Skip ahead to avoid overlapping matches
         } else {
             i++;
         }
     }
+    control.checkpoint(positions, positions);
 
     // Format result string
     std::ostringstream result;
@@ -392,97 +1015,371 @@ std::string SoundSegment::identify(const SoundSegment& ad) const {
 void SoundSegment::insert(const SoundSegment& src_track, size_t dest_pos, size_t src_pos, size_t len) {
     if (len == 0) return;
 
-    size_t remaining = len;
-    size_t current_global = src_pos;
+    size_t available = src_pos < src_track.total_length
+                           ? std::min(len, src_track.total_length - src_pos) : 0;
+    if (available == 0) return;
 
-    std::shared_ptr<SegmentNode> insertion_head = nullptr;
-    std::shared_ptr<SegmentNode> insertion_tail = nullptr;
+    // Within one track the samples can be shared instead of copied
+    if (&src_track == this) {
+        duplicateRange(src_pos, available, dest_pos);
+        return;
+    }
 
-    // Build the list of segments to insert
-    while (remaining > 0) {
-        size_t local_off;
-        auto cur_node = src_track.findSegmentAt(current_global, local_off);
-        if (!cur_node) break;
+    // Copy the whole source range into a single buffer: one allocation per
+    // insert instead of one per source segment.
+    std::shared_ptr<SegmentNode> insertion_tail;
+    auto insertion_head = allocateSegments(available, insertion_tail);
+    for (auto node = insertion_head; node; node = node->next) {
+        src_track.read(node->data->data(), src_pos + node->global_start, node->length);
+    }
 
-        // Calculate how much of this segment we need
-        size_t take = std::min(cur_node->length - local_off, remaining);
+    flushWrites();
+    RangeLock lock = lockStructure(dest_pos);
+    spliceIn(dest_pos, insertion_head, insertion_tail);
+}
 
-        // Create a new segment that shares data with the source segment
-        auto clone = createSegment(cur_node->data, cur_node->offset + local_off, take);
-        clone->addParent(cur_node);
-        
-        // Note: We would need to modify the const constraint to add child relationships
-        // For now, we'll create a copy instead of sharing (safer approach)
-        auto data_copy = std::make_shared<std::vector<int16_t>>(take);
-        std::memcpy(data_copy->data(), 
-                   cur_node->data->data() + cur_node->offset + local_off,
-                   take * BYTES_PER_SAMPLE);
-        clone = createSegment(data_copy, 0, take);
-        clone->is_buffer_owner = true;
-
-        if (!insertion_head) {
-            insertion_head = clone;
-            insertion_tail = clone;
-        } else {
-            insertion_tail->next = clone;
-            insertion_tail = clone;
-        }
+void SoundSegment::insert(size_t dest_pos, const int16_t* samples, size_t len) {
+    if (!samples || len == 0) return;
 
-        remaining -= take;
-        current_global += take;
+    // One copy straight into the new segment's buffer
+    std::shared_ptr<SegmentNode> insertion_tail;
+    auto insertion_head = allocateSegments(len, insertion_tail);
+    size_t copied = 0;
+    for (auto node = insertion_head; node; node = node->next) {
+        std::memcpy(node->data->data(), samples + copied, node->length * BYTES_PER_SAMPLE);
+        copied += node->length;
     }
 
-    // Find where to insert in destination track
-    size_t dest_local;
-    auto dest_node = findSegmentAt(dest_pos, dest_local);
-    
-    if (dest_node && dest_local > 0) {
-        dest_node = splitNode(dest_node, dest_local);
+    flushWrites();
+    RangeLock lock = lockStructure(dest_pos);
+    spliceIn(dest_pos, insertion_head, insertion_tail);
+}
+
+void SoundSegment::insert(size_t dest_pos, std::shared_ptr<SampleBuffer> buffer) {
+    if (!buffer || buffer->size() == 0) return;
+    if (buffer->size() > SEGMENT_MAX_LENGTH) {
+        throw std::runtime_error("Inserted buffer exceeds the maximum segment length");
     }
 
-    // Insert the new segments into the destination track
-    if (!dest_node) {
-        // Insert at end of track
-        if (!head) {
-            head = insertion_head;
-        } else {
-            auto tail = head;
-            while (tail->next) {
-                tail = tail->next;
-            }
-            tail->next = insertion_head;
-        }
+    auto node = createSegment(buffer, 0, buffer->size());
+    node->flags |= SEGMENT_BUFFER_OWNER;
+
+    flushWrites();
+    RangeLock lock = lockStructure(dest_pos);
+    spliceIn(dest_pos, node, node);
+}
+
+void SoundSegment::insert(size_t dest_pos, std::vector<int16_t>&& samples) {
+    if (samples.empty()) return;
+
+    if (samples.size() > SEGMENT_MAX_LENGTH) {
+        insert(dest_pos, samples.data(), samples.size());
+        return;
+    }
+    insert(dest_pos, SampleBuffer::adopt(std::move(samples)));
+}
+
+void SoundSegment::insert(size_t dest_pos, int16_t* samples, size_t count, SampleBuffer::Deleter deleter) {
+    if (!samples || count == 0) return;
+    insert(dest_pos, SampleBuffer::wrap(samples, count, std::move(deleter)));
+}
+
+void SoundSegment::spliceIn(size_t pos, std::shared_ptr<SegmentNode> first,
+                            std::shared_ptr<SegmentNode> last) {
+    // Link first..last in at pos (or at the end if pos is past it). Callers
+    // hold the structural lock.
+    invalidateIndex();
+
+    size_t old_length = total_length;
+    size_t at = std::min(pos, old_length);
+    auto prev = boundaryAt(at);
+    auto rest = prev ? prev->next : head;
+    if (prev) {
+        prev->next = first;
     } else {
-        // Inserting in middle of track
-        if (head == dest_node) {
-            insertion_tail->next = dest_node;
-            head = insertion_head;
-        } else {
-            auto prev = head;
-            while (prev && prev->next != dest_node) {
-                prev = prev->next;
+        head = first;
+    }
+    last->next = rest;
+
+    reindexFrom(prev);
+    marker_index->onInsert(at, total_length - old_length);
+}
+
+std::shared_ptr<SegmentNode> SoundSegment::detachRange(size_t pos, size_t len,
+                                                       std::shared_ptr<SegmentNode>& last) {
+    // Unlink the segments covering [pos, pos + len) and return them as a
+    // chain ending at last. Callers hold the structural lock and have
+    // checked that the range lies inside the track.
+    invalidateIndex();
+
+    auto prev = boundaryAt(pos);
+    last = boundaryAt(pos + len);
+    auto first = prev ? prev->next : head;
+    auto rest = last->next;
+    if (prev) {
+        prev->next = rest;
+    } else {
+        head = rest;
+    }
+    last->next = nullptr;
+    reindexFrom(prev);
+    marker_index->onDelete(pos, len);
+
+    size_t global_pos = 0;
+    for (auto node = first; node; node = node->next) {
+        node->global_start = global_pos;
+        global_pos += node->length;
+    }
+    return first;
+}
+
+bool SoundSegment::moveRange(SoundSegment& src, size_t src_pos, size_t len, size_t dest_pos) {
+    if (&src == this) {
+        return moveWithin(src_pos, len, dest_pos);
+    }
+
+    src.flushWrites();
+    flushWrites();
+
+    // The tracks are locked one after the other, never together, so two
+    // opposite moves between the same tracks cannot deadlock
+    std::shared_ptr<SegmentNode> first;
+    std::shared_ptr<SegmentNode> last;
+    {
+        RangeLock lock = src.lockStructure(src_pos);
+        if (len > src.total_length || src_pos > src.total_length - len) {
+            return false;
+        }
+        if (len == 0) {
+            return true;
+        }
+        first = src.detachRange(src_pos, len, last);
+    }
+
+    RangeLock lock = lockStructure(dest_pos);
+    spliceIn(dest_pos, first, last);
+    return true;
+}
+
+bool SoundSegment::moveWithin(size_t src_pos, size_t len, size_t dest_pos) {
+    flushWrites();
+    RangeLock lock = lockStructure(std::min(src_pos, dest_pos));
+
+    if (len > total_length || src_pos > total_length - len) {
+        return false;
+    }
+    // The destination must not fall strictly inside the range being moved
+    if (dest_pos > src_pos && dest_pos < src_pos + len) {
+        return false;
+    }
+    if (len == 0) {
+        return true;
+    }
+
+    std::shared_ptr<SegmentNode> last;
+    auto first = detachRange(src_pos, len, last);
+    spliceIn(dest_pos >= src_pos + len ? dest_pos - len : dest_pos, first, last);
+    return true;
+}
+
+std::shared_ptr<SegmentNode> SoundSegment::shareSegments(std::shared_ptr<SegmentNode>& cursor, size_t pos,
+                                                         size_t len, std::shared_ptr<SegmentNode>& last) const {
+    // Build new nodes describing [pos, pos + len) over the same buffers,
+    // starting the walk at cursor and leaving it on the last node used, so
+    // consecutive ranges cost one pass in total. The new chain is numbered
+    // from zero. Callers hold a lock covering the range.
+    std::shared_ptr<SegmentNode> first;
+    last = nullptr;
+    size_t remaining = len;
+    size_t chain_length = 0;
+    bool newly_shared = false;
+    while (cursor && remaining > 0) {
+        size_t node_end = cursor->global_start + cursor->length;
+        if (pos < node_end) {
+            size_t count = std::min(node_end - pos, remaining);
+
+            // Two segments now read the same samples, so neither may write in place
+            if (!cursor->data->isShared()) {
+                cursor->data->markShared();
+                newly_shared = true;
             }
-            if (prev) {
-                prev->next = insertion_head;
-                insertion_tail->next = dest_node;
+            auto clone = createSegment(cursor->data, cursor->offset + (pos - cursor->global_start), count);
+            clone->global_start = chain_length;
+            if (last) {
+                last->next = clone;
+            } else {
+                first = clone;
             }
+            last = clone;
+            chain_length += count;
+            remaining -= count;
+            pos += count;
+        }
+        if (remaining > 0) {
+            cursor = cursor->next;
         }
     }
-    
-    updateGlobalIndices();
+
+    // A cached table still flags these buffers as private and would let
+    // writers copy straight into them; the next reader rebuilds it
+    if (newly_shared && index) {
+        index->clear();
+    }
+    return first;
+}
+
+bool SoundSegment::duplicateRange(size_t src_pos, size_t len, size_t dest_pos) {
+    flushWrites();
+    RangeLock lock = lockStructure(std::min(src_pos, dest_pos));
+
+    if (len > total_length || src_pos > total_length - len) {
+        return false;
+    }
+    if (len == 0) {
+        return true;
+    }
+
+    // Describe the source range with new nodes over the same buffers before
+    // touching the list, so a destination inside the range sees the original
+    auto cursor = head;
+    std::shared_ptr<SegmentNode> last;
+    auto first = shareSegments(cursor, src_pos, len, last);
+
+    spliceIn(dest_pos, first, last);
+    return true;
+}
+
+std::vector<std::unique_ptr<SoundSegment>> SoundSegment::split(const std::vector<size_t>& cut_points) const {
+    flushWrites();
+    RangeLock lock(*locks, 0, RANGE_LOCK_END, RangeLockMode::Shared);
+
+    size_t track_length = total_length;
+    for (size_t i = 0; i < cut_points.size(); ++i) {
+        if (cut_points[i] > track_length || (i > 0 && cut_points[i] < cut_points[i - 1])) {
+            throw std::runtime_error("Cut points must be ascending and within the track");
+        }
+    }
+
+    // One walk over the list serves every part
+    std::vector<std::unique_ptr<SoundSegment>> parts;
+    parts.reserve(cut_points.size() + 1);
+    auto cursor = head;
+    size_t start = 0;
+    for (size_t i = 0; i <= cut_points.size(); ++i) {
+        size_t end = i < cut_points.size() ? cut_points[i] : track_length;
+        auto part = create();
+        std::shared_ptr<SegmentNode> last;
+        part->head = shareSegments(cursor, start, end - start, last);
+        part->total_length = end - start;
+        parts.push_back(std::move(part));
+        start = end;
+    }
+    return parts;
+}
+
+std::unique_ptr<SoundSegment> SoundSegment::concat(const std::vector<const SoundSegment*>& tracks) {
+    TrackBuilder builder;
+    for (const SoundSegment* track : tracks) {
+        if (!track) {
+            throw std::runtime_error("Cannot concatenate a null track");
+        }
+        builder.append(*track);
+    }
+    return builder.build();
+}
+
+MarkerIndex& SoundSegment::markers() {
+    return *marker_index;
+}
+
+const MarkerIndex& SoundSegment::markers() const {
+    return *marker_index;
+}
+
+SoundSegmentView SoundSegment::view(size_t start, size_t len) const {
+    return SoundSegmentView(*this, start, len);
 }
 
 void SoundSegment::loadFromWav(const std::string& filename) {
-    auto samples = WavIO::load(filename);
-    write(samples, 0);
+    loadFromWav(filename, OperationControl::unbounded());
+}
+
+void SoundSegment::loadFromWav(const std::string& filename, const OperationControl& control) {
+    // The whole file is decoded before the track is touched, so an aborted
+    // load leaves the track unchanged
+    auto samples = WavIO::load(filename, control);
+    adopt(std::move(samples), 0);
 }
 
 void SoundSegment::saveToWav(const std::string& filename) const {
-    auto samples = getAllSamples();
-    WavIO::save(filename, samples);
+    saveToWav(filename, OperationControl::unbounded());
+}
+
+void SoundSegment::saveToWav(const std::string& filename, const OperationControl& control) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot create file: " + filename);
+    }
+
+    // Hold the whole track so concurrent edits cannot tear the file
+    flushWrites();
+    RangeLock lock(*locks, 0, RANGE_LOCK_END, RangeLockMode::Shared);
+    size_t track_length = total_length;
+    WavIO::writeHeader(file, track_length);
+
+    // Stream the track in blocks instead of materialising every sample
+    size_t block = std::max<size_t>(control.block_size, 1);
+    ScratchScope scratch;
+    int16_t* buffer = scratch.allocateArray<int16_t>(std::min(block, track_length));
+    size_t written = 0;
+    try {
+        while (written < track_length) {
+            control.checkpoint(written, track_length);
+            size_t count = std::min(block, track_length - written);
+            readUnlocked(buffer, written, count);
+            file.write(reinterpret_cast<const char*>(buffer), count * BYTES_PER_SAMPLE);
+            written += count;
+        }
+        control.checkpoint(written, track_length);
+    } catch (const OperationAborted&) {
+        file.close();
+        std::remove(filename.c_str());
+        throw;
+    }
+
+    if (!file) {
+        throw std::runtime_error("Error writing to file: " + filename);
+    }
+}
+
+AsyncOperation<void> SoundSegment::loadAsync(const std::string& filename,
+                                             const OperationControl& control,
+                                             Scheduler& scheduler) {
+    return AsyncOperation<void>::run(scheduler, [this, filename, control]() {
+        loadFromWav(filename, control);
+    });
+}
+
+AsyncOperation<void> SoundSegment::saveAsync(const std::string& filename,
+                                             const OperationControl& control,
+                                             Scheduler& scheduler) const {
+    return AsyncOperation<void>::run(scheduler, [this, filename, control]() {
+        saveToWav(filename, control);
+    }, preferredNode());
+}
+
+AsyncOperation<std::string> SoundSegment::identifyAsync(const SoundSegment& ad,
+                                                        const OperationControl& control,
+                                                        Scheduler& scheduler) const {
+    const SoundSegment* ad_ptr = &ad;
+    return AsyncOperation<std::string>::run(scheduler, [this, ad_ptr, control]() {
+        return identify(*ad_ptr, control);
+    }, preferredNode());
 }
 
 void SoundSegment::printTrack() const {
+    flushWrites();
+    RangeLock lock(*locks, 0, RANGE_LOCK_END, RangeLockMode::Shared);
     std::cout << "Track (total_length=" << total_length << "):\n";
     auto current = head;
     
@@ -500,9 +1397,79 @@ void SoundSegment::printTrack() const {
     std::cout << "\n";
 }
 
+std::shared_ptr<const SegmentTable> SoundSegment::snapshot() const {
+    flushWrites();
+    RangeLock lock(*locks, 0, RANGE_LOCK_END, RangeLockMode::Shared);
+
+    // From now on neither this track nor the snapshot may write these buffers
+    for (auto current = head; current; current = current->next) {
+        current->data->markShared();
+    }
+
+    // The table records the shared flags, so in-place writers see them too.
+    // Markers are captured with the audio so restore() can put both back.
+    auto table = SegmentTable::build(head, marker_index->all());
+    if (index) {
+        index->set(table);
+    }
+    return table;
+}
+
+void SoundSegment::restore(const std::shared_ptr<const SegmentTable>& snap) {
+    if (!snap) return;
+
+    flushWrites();
+    RangeLock lock = lockStructure(0);
+    invalidateIndex();
+
+    std::shared_ptr<SegmentNode> first;
+    std::shared_ptr<SegmentNode> last;
+    for (size_t i = 0; i < snap->segmentCount(); ++i) {
+        const SegmentDescriptor& segment = snap->segments[i];
+        auto node = createSegment(snap->buffers[segment.buffer], segment.offset, segment.length);
+        node->flags = segment.flags & ~SEGMENT_SHARED;
+        node->global_start = snap->starts[i];
+        if (last) {
+            last->next = node;
+        } else {
+            first = node;
+        }
+        last = node;
+    }
+
+    head = first;
+    total_length = snap->totalLength();
+    marker_index->assign(snap->markers);
+
+    // The snapshot describes the restored list exactly
+    if (index) {
+        index->set(snap);
+    }
+}
+
+int SoundSegment::preferredNode() const {
+    const NumaTopology& topology = NumaTopology::instance();
+    if (!topology.isNuma()) {
+        return head ? 0 : -1;
+    }
+
+    // Weight each buffer's node by the samples this track uses from it
+    RangeLock lock(*locks, 0, RANGE_LOCK_END, RangeLockMode::Shared);
+    std::vector<size_t> samples_per_node(topology.nodeCount(), 0);
+    for (auto current = head; current; current = current->next) {
+        int node = current->data ? current->data->node() : -1;
+        if (node >= 0 && static_cast<size_t>(node) < samples_per_node.size()) {
+            samples_per_node[node] += current->length;
+        }
+    }
+
+    auto best = std::max_element(samples_per_node.begin(), samples_per_node.end());
+    return *best > 0 ? static_cast<int>(best - samples_per_node.begin()) : -1;
+}
+
 std::vector<int16_t> SoundSegment::getAllSamples() const {
-    std::vector<int16_t> result(total_length);
-    read(result.data(), 0, total_length);
+    std::vector<int16_t> result;
+    read(result, 0, RANGE_LOCK_END);
     return result;
 }
 
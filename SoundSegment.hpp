@@ -6,6 +6,22 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <atomic>
+
+#include "AsyncOperation.hpp"
+#include "Decimate.hpp"
+#include "MarkerIndex.hpp"
+#include "OperationControl.hpp"
+#include "RangeLock.hpp"
+#include "SampleBuffer.hpp"
+#include "SampleConvert.hpp"
+#include "SegmentTable.hpp"
+#include "SoundSegmentView.hpp"
+#include "WriteCoalescer.hpp"
 
 namespace AudioEditor {
 
@@ -21,36 +37,48 @@ constexpr size_t BYTES_PER_SAMPLE = 2;
 constexpr size_t INITIAL_OFFSET = 0;
 constexpr size_t MAX_OCCURRENCE_STRING_LENGTH = 32;
 
+// Granularity of copy-on-write for buffers shared with snapshots (8 KiB)
+constexpr size_t COW_BLOCK_SAMPLES = 4096;
+
+// Samples per chunk of a track's piece-table add buffer
+constexpr size_t PIECE_ADD_BUFFER_SAMPLES = 65536;
+
+/**
+ * How write() treats samples that already exist in the track.
+ */
+enum class WriteMode {
+    InPlace,    // Overwrite buffers directly (copying first if a snapshot shares them)
+    PieceTable  // Append to the track's add buffer and splice in a piece referencing it
+};
+
 // Forward declarations
 class SegmentNode;
 class SoundSegment;
+class TrackBuilder;
+class Timeline;
+class StftFrames;
 
 /**
  * A node in the linked list of audio segments.
  * Each node represents a contiguous block of audio samples with metadata.
+ * Offsets and lengths are 32-bit (see SEGMENT_MAX_LENGTH) to keep nodes small.
  */
 class SegmentNode {
 public:
-    std::shared_ptr<std::vector<int16_t>> data;  // Shared pointer to audio data
-    size_t offset;                               // Offset into shared data buffer
-    size_t length;                               // Number of samples in this segment
-    size_t global_start;                         // Starting global index of this node's samples
+    std::shared_ptr<SampleBuffer> data;          // Shared pointer to audio data
     std::shared_ptr<SegmentNode> next;           // Pointer to the next segment
-
-    std::vector<std::weak_ptr<SegmentNode>> parents;   // Parent nodes
-    std::vector<std::weak_ptr<SegmentNode>> children;  // Child nodes
-    bool is_buffer_owner;                               // True if this node owns the buffer
+    size_t global_start;                         // Starting global index of this node's samples
+    uint32_t offset;                             // Offset into shared data buffer
+    uint32_t length;                             // Number of samples in this segment
+    uint32_t flags;                              // SEGMENT_* bits
 
     SegmentNode();
-    SegmentNode(std::shared_ptr<std::vector<int16_t>> data_ptr, size_t offset, size_t len);
-    ~SegmentNode() = default;
+    SegmentNode(std::shared_ptr<SampleBuffer> data_ptr, size_t offset, size_t len);
+    // Unlinks the rest of the chain iteratively, so dropping a list of any
+    // length (track teardown, restore, detached ranges) uses constant stack
+    ~SegmentNode();
 
-    // Add parent-child relationships
-    void addChild(std::shared_ptr<SegmentNode> child);
-    void addParent(std::shared_ptr<SegmentNode> parent);
-    
-    // Check if node has active children (for deletion checks)
-    bool hasActiveChildren() const;
+    bool isBufferOwner() const { return (flags & SEGMENT_BUFFER_OWNER) != 0; }
 };
 
 /**
@@ -59,24 +87,78 @@ public:
 class WavIO {
 public:
     static std::vector<int16_t> load(const std::string& filename);
+    static std::vector<int16_t> load(const std::string& filename, const OperationControl& control);
     static void save(const std::string& filename, const std::vector<int16_t>& samples);
+    static void save(const std::string& filename, const std::vector<int16_t>& samples,
+                     const OperationControl& control);
+
+    // Write a canonical 44-byte PCM header for the given number of samples
+    static void writeHeader(std::ostream& out, size_t num_samples);
 };
 
 /**
  * The main SoundSegment class representing a sequence of audio segments.
  * Replaces the C struct sound_seg with an object-oriented design.
+ *
+ * Operations lock only the sample range they touch, so threads editing
+ * disjoint regions run in parallel. Overwrites lock [pos, pos + len);
+ * insert, deleteRange and extending writes lock from the start of the
+ * affected segment to the end of the track, since every later position
+ * shifts. Only segments after the edit point are renumbered.
+ *
+ * The linked list is the edit structure. Reads and in-place writes go
+ * through a SegmentTable (parallel arrays searched by binary search) when
+ * one is cached; structural edits drop it and the next fragmented read
+ * rebuilds it.
  */
 class SoundSegment {
 private:
     std::shared_ptr<SegmentNode> head;  // Pointer to the first segment
-    size_t total_length;                // Total number of samples in the track
+    std::atomic<size_t> total_length;   // Total number of samples in the track
+    std::shared_ptr<RangeLockTable> locks;  // Sample ranges held by in-flight operations
+    std::shared_ptr<SegmentTableCache> index;  // Array view of the list, rebuilt on demand
+    std::atomic<WriteMode> write_mode;
+    std::shared_ptr<SampleBuffer> add_buffer;  // Append-only storage for piece-table writes
+    size_t add_used;                           // Samples of add_buffer already referenced
+    std::atomic<bool> coalesce_writes;
+    std::shared_ptr<WriteCoalescer> pending;   // Small writes not yet applied
+    std::shared_ptr<MarkerIndex> marker_index;  // Shifted by every insert and delete
 
     // Helper methods
     void updateGlobalIndices();
+    void reindexFrom(std::shared_ptr<SegmentNode> prev);
+    RangeLock lockStructure(size_t pos) const;
+    void readUnlocked(int16_t* dest, size_t start_pos, size_t len) const;
+    std::shared_ptr<const SegmentTable> currentTable() const;
+    void invalidateIndex();
+    void tryRebuildIndex() const;
     std::shared_ptr<SegmentNode> findSegmentAt(size_t pos, size_t& local_offset) const;
     std::shared_ptr<SegmentNode> splitNode(std::shared_ptr<SegmentNode> node, size_t local_offset);
-    std::shared_ptr<SegmentNode> createSegment(std::shared_ptr<std::vector<int16_t>> data, 
-                                               size_t offset, size_t len);
+    static std::shared_ptr<SegmentNode> createSegment(std::shared_ptr<SampleBuffer> data, 
+                                                      size_t offset, size_t len);
+    std::shared_ptr<SegmentNode> allocateSegments(size_t len, std::shared_ptr<SegmentNode>& tail);
+    bool touchesShared(size_t pos, size_t len) const;
+    void privatizeRange(size_t pos, size_t len);
+    std::shared_ptr<SegmentNode> boundaryAt(size_t pos);
+    std::shared_ptr<SegmentNode> appendPieces(const int16_t* src, size_t len,
+                                              std::shared_ptr<SegmentNode>& tail);
+    void writePieces(const int16_t* src, size_t pos, size_t len);
+    void replaceRange(size_t pos, std::shared_ptr<SegmentNode> pieces, std::shared_ptr<SegmentNode> tail);
+    void spliceIn(size_t pos, std::shared_ptr<SegmentNode> first, std::shared_ptr<SegmentNode> last);
+    std::shared_ptr<SegmentNode> detachRange(size_t pos, size_t len, std::shared_ptr<SegmentNode>& last);
+    bool moveWithin(size_t src_pos, size_t len, size_t dest_pos);
+    std::shared_ptr<SegmentNode> shareSegments(std::shared_ptr<SegmentNode>& cursor, size_t pos, size_t len,
+                                               std::shared_ptr<SegmentNode>& last) const;
+    void writeNow(const int16_t* src, size_t pos, size_t len);
+    void applyRuns(const std::vector<WriteCoalescer::Run>& runs);
+    void flushOverlapping(size_t start_pos, size_t len) const;
+    std::string identifyIn(size_t start, size_t len, const SoundSegment& ad,
+                           const OperationControl& control) const;
+
+    friend class TrackBuilder;
+    friend class SoundSegmentView;
+    friend class Timeline;
+    friend class StftFrames;
 
 public:
     // Constructors and destructor
@@ -93,22 +175,123 @@ public:
 
     // Basic track operations
     size_t length() const;
+    // Vector reads are clamped to the track: dest is resized to the samples
+    // that exist in [start_pos, start_pos + len), and is empty past the end
     void read(std::vector<int16_t>& dest, size_t start_pos, size_t len) const;
     void read(int16_t* dest, size_t start_pos, size_t len) const;
+
+    // Reads converted during the segment copy: float is sample * scale,
+    // int32 is sample << shift. dest[i * stride] receives sample i, so a
+    // stride of the channel count fills one channel of an interleaved buffer.
+    void read(float* dest, size_t start_pos, size_t len, float scale = SAMPLE_FLOAT_SCALE,
+              size_t stride = 1) const;
+    void read(int32_t* dest, size_t start_pos, size_t len, int shift = SAMPLE_INT32_SHIFT,
+              size_t stride = 1) const;
+    void read(std::vector<float>& dest, size_t start_pos, size_t len, float scale = SAMPLE_FLOAT_SCALE) const;
+    void read(std::vector<int32_t>& dest, size_t start_pos, size_t len, int shift = SAMPLE_INT32_SHIFT) const;
+
+    // One output per factor samples (two for MinMax) of [start_pos, start_pos + len),
+    // reduced directly from segment memory for scrubbing and thumbnails
+    void readDecimated(std::vector<int16_t>& dest, size_t start_pos, size_t len, size_t factor,
+                       DecimateMode mode) const;
+
     void write(const std::vector<int16_t>& src, size_t pos);
     void write(const int16_t* src, size_t pos, size_t len);
+
+    // Like write, but the samples become a segment's backing store without
+    // being copied. The track may later modify them in place (InPlace mode).
+    void adopt(std::vector<int16_t>&& samples, size_t pos);
+    void adopt(int16_t* samples, size_t count, SampleBuffer::Deleter deleter, size_t pos);
+    void adopt(std::shared_ptr<SampleBuffer> buffer, size_t pos);
+    
+    // In PieceTable mode existing buffers are never modified, so sharing
+    // them with snapshots is always free
+    void setWriteMode(WriteMode mode);
+    WriteMode writeMode() const;
+
+    // Hold back small in-range writes and apply them together, merged and
+    // sorted. Reads of an affected range and structural edits flush first.
+    void setWriteCoalescing(bool enabled);
+    void flushWrites() const;
+    size_t pendingWrites() const;
     
     // Advanced operations
     bool deleteRange(size_t pos, size_t len);
     std::string identify(const SoundSegment& ad) const;
+    std::string identify(const SoundSegment& ad, const OperationControl& control) const;
     void insert(const SoundSegment& src_track, size_t dest_pos, size_t src_pos, size_t len);
+
+    // Insert samples from memory as new segments at dest_pos. The pointer
+    // variant copies once; the others adopt the memory without copying.
+    void insert(size_t dest_pos, const int16_t* samples, size_t len);
+    void insert(size_t dest_pos, std::vector<int16_t>&& samples);
+    void insert(size_t dest_pos, int16_t* samples, size_t count, SampleBuffer::Deleter deleter);
+    void insert(size_t dest_pos, std::shared_ptr<SampleBuffer> buffer);
+
+    // Cut [src_pos, src_pos + len) out of src and link its segments in at
+    // dest_pos, without copying samples. Ownership of the buffers moves with
+    // the segments. When src is this track, dest_pos is a position before
+    // the move and may not lie strictly inside the moved range. Returns
+    // false if the range is invalid.
+    bool moveRange(SoundSegment& src, size_t src_pos, size_t len, size_t dest_pos);
+
+    // Insert a copy of [src_pos, src_pos + len) at dest_pos, sharing the
+    // existing buffers. dest_pos may lie inside the source range; the copy
+    // is always of the range as it was before the call.
+    bool duplicateRange(size_t src_pos, size_t len, size_t dest_pos);
+
+    // Cut the track at the given ascending positions into cut_points.size() + 1
+    // new tracks that share this track's buffers. This track is unchanged.
+    std::vector<std::unique_ptr<SoundSegment>> split(const std::vector<size_t>& cut_points) const;
+
+    // New track holding the given tracks back to back, sharing their
+    // buffers. Costs one pass over the sources' segments (see TrackBuilder).
+    static std::unique_ptr<SoundSegment> concat(const std::vector<const SoundSegment*>& tracks);
+
+    // Read-only window onto [start, start + len) of this track; O(1), no copies
+    SoundSegmentView view(size_t start, size_t len) const;
+
+    // Positions and regions that move with inserts and deletes. Edits that
+    // move material (moveRange) count as a delete followed by an insert.
+    MarkerIndex& markers();
+    const MarkerIndex& markers() const;
     
     // WAV file operations
     void loadFromWav(const std::string& filename);
     void saveToWav(const std::string& filename) const;
+    void loadFromWav(const std::string& filename, const OperationControl& control);
+    void saveToWav(const std::string& filename, const OperationControl& control) const;
+
+    // Asynchronous variants run on a Scheduler (the library one by default).
+    // The track, and the ad for identifyAsync, must outlive the operation.
+    AsyncOperation<void> loadAsync(const std::string& filename,
+                                   const OperationControl& control = OperationControl(),
+                                   Scheduler& scheduler = Scheduler::instance());
+    AsyncOperation<void> saveAsync(const std::string& filename,
+                                   const OperationControl& control = OperationControl(),
+                                   Scheduler& scheduler = Scheduler::instance()) const;
+    AsyncOperation<std::string> identifyAsync(const SoundSegment& ad,
+                                              const OperationControl& control = OperationControl(),
+                                              Scheduler& scheduler = Scheduler::instance()) const;
     
     // Utility methods for testing and debugging
     void printTrack() const;
+
+    // Build the segment table now instead of on the next fragmented read
+    void rebuildIndex() const;
+    bool isIndexed() const;
+
+    // Visit [start_pos, start_pos + len) as contiguous runs of samples
+    void scan(size_t start_pos, size_t len, const SegmentTable::SpanVisitor& visit) const;
+
+    // Immutable copy of the segment structure and markers. Buffers are
+    // shared, not copied; later writes to either side copy the affected
+    // samples first. restore() puts the markers back as they were.
+    std::shared_ptr<const SegmentTable> snapshot() const;
+    void restore(const std::shared_ptr<const SegmentTable>& snap);
+
+    // NUMA node holding most of the track's samples (-1 if empty or interleaved)
+    int preferredNode() const;
     std::vector<int16_t> getAllSamples() const;
     
     // Static factory method
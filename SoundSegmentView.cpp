@@ -0,0 +1,65 @@
+#include "SoundSegmentView.hpp"
+#include "SoundSegment.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace AudioEditor {
+
+SoundSegmentView::SoundSegmentView(const SoundSegment& track, size_t start, size_t len)
+    : parent(&track), first(start), count(len) {
+    size_t track_length = track.length();
+    if (len > track_length || start > track_length - len) {
+        throw std::runtime_error("View range is outside the track");
+    }
+}
+
+void SoundSegmentView::read(std::vector<int16_t>& dest, size_t start_pos, size_t len) const {
+    size_t available = start_pos < count ? std::min(len, count - start_pos) : 0;
+    parent->read(dest, first + start_pos, available);
+}
+
+void SoundSegmentView::read(int16_t* dest, size_t start_pos, size_t len) const {
+    if (len > count || start_pos > count - len) {
+        throw std::runtime_error("Read range is outside the view");
+    }
+    parent->read(dest, first + start_pos, len);
+}
+
+std::vector<int16_t> SoundSegmentView::getAllSamples() const {
+    std::vector<int16_t> samples;
+    read(samples, 0, count);
+    return samples;
+}
+
+void SoundSegmentView::scan(size_t start_pos, size_t len, const SegmentTable::SpanVisitor& visit) const {
+    size_t available = start_pos < count ? std::min(len, count - start_pos) : 0;
+    if (available > 0) {
+        parent->scan(first + start_pos, available, visit);
+    }
+}
+
+SoundSegmentView SoundSegmentView::view(size_t start_pos, size_t len) const {
+    if (len > count || start_pos > count - len) {
+        throw std::runtime_error("View range is outside the view");
+    }
+    return SoundSegmentView(*parent, first + start_pos, len);
+}
+
+std::string SoundSegmentView::identify(const SoundSegment& ad) const {
+    return identify(ad, OperationControl::unbounded());
+}
+
+std::string SoundSegmentView::identify(const SoundSegment& ad, const OperationControl& control) const {
+    return parent->identifyIn(first, count, ad, control);
+}
+
+size_t SoundSegmentView::Cursor::read(int16_t* dest, size_t n) {
+    size_t taken = std::min(n, remaining());
+    if (taken > 0) {
+        view->read(dest, pos, taken);
+        pos += taken;
+    }
+    return taken;
+}
+
+}  // namespace AudioEditor
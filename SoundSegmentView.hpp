@@ -0,0 +1,79 @@
+#ifndef SOUND_SEGMENT_VIEW_HPP
+#define SOUND_SEGMENT_VIEW_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "OperationControl.hpp"
+#include "SegmentTable.hpp"
+
+namespace AudioEditor {
+
+class SoundSegment;
+
+/**
+ * Read-only window [start, start + length) onto a track. A view is a
+ * pointer and two positions: creating one allocates nothing and copies no
+ * nodes, so a track can be partitioned for parallel workers for free.
+ *
+ * Reads go through the parent with the usual range locks and see the
+ * parent's current contents; positions are relative to the view. The
+ * parent must outlive its views. Samples past the parent's current end
+ * are not returned.
+ */
+class SoundSegmentView {
+private:
+    const SoundSegment* parent;
+    size_t first;  // Parent position of the view's sample 0
+    size_t count;
+
+public:
+    /**
+     * Sequential reader over a view. Each read continues where the last
+     * one stopped.
+     */
+    class Cursor {
+    private:
+        const SoundSegmentView* view;
+        size_t pos;
+
+    public:
+        explicit Cursor(const SoundSegmentView& v, size_t start = 0) : view(&v), pos(start) {}
+
+        // Copy up to n samples and advance; returns the number copied
+        size_t read(int16_t* dest, size_t n);
+
+        void seek(size_t p) { pos = p; }
+        size_t position() const { return pos; }
+        size_t remaining() const { return pos < view->length() ? view->length() - pos : 0; }
+        bool atEnd() const { return remaining() == 0; }
+    };
+
+    SoundSegmentView(const SoundSegment& track, size_t start, size_t len);
+
+    size_t start() const { return first; }
+    size_t length() const { return count; }
+    const SoundSegment& track() const { return *parent; }
+
+    void read(std::vector<int16_t>& dest, size_t start_pos, size_t len) const;
+    void read(int16_t* dest, size_t start_pos, size_t len) const;
+    std::vector<int16_t> getAllSamples() const;
+
+    // Visit [start_pos, start_pos + len) of the view as contiguous runs
+    void scan(size_t start_pos, size_t len, const SegmentTable::SpanVisitor& visit) const;
+
+    Cursor cursor(size_t start_pos = 0) const { return Cursor(*this, start_pos); }
+
+    // Narrower view of the same track; positions are relative to this view
+    SoundSegmentView view(size_t start_pos, size_t len) const;
+
+    // Search only this window; reported positions are relative to the view
+    std::string identify(const SoundSegment& ad) const;
+    std::string identify(const SoundSegment& ad, const OperationControl& control) const;
+};
+
+}  // namespace AudioEditor
+
+#endif  // SOUND_SEGMENT_VIEW_HPP
@@ -0,0 +1,175 @@
+#include "Stft.hpp"
+#include "ScratchArena.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace AudioEditor {
+
+size_t StftConfig::resolvedFftSize() const {
+    if (fft_size != 0) {
+        return fft_size;
+    }
+    size_t size = 2;
+    while (size < frame_length) {
+        size <<= 1;
+    }
+    return size;
+}
+
+// ========== StftFrames Implementation ==========
+
+StftFrames::StftFrames(const SoundSegment& track, size_t start, size_t len, const StftConfig& settings)
+    : config(settings), first(start), count(0), frames(0), cursor(0) {
+    if (config.frame_length == 0 || config.hop == 0) {
+        throw std::runtime_error("Frame length and hop must be at least 1");
+    }
+
+    track.flushWrites();
+    lock = RangeLock(*track.locks, 0, RANGE_LOCK_END, RangeLockMode::Shared);
+
+    size_t track_length = track.total_length;
+    count = start < track_length ? std::min(len, track_length - start) : 0;
+    frames = frameCount(count, config);
+
+    // Frames are located by binary search, so make sure there is a table
+    table = track.currentTable();
+    if (!table) {
+        table = SegmentTable::build(track.head);
+        if (track.index) track.index->set(table);
+    }
+
+    coefficients = makeWindow(config.window, config.frame_length);
+    for (float& c : coefficients) {
+        c *= SAMPLE_FLOAT_SCALE;
+    }
+    staging.resize(config.frame_length);
+}
+
+size_t StftFrames::frameCount(size_t len, const StftConfig& config) {
+    if (len == 0 || config.hop == 0) {
+        return 0;
+    }
+    if (len <= config.frame_length) {
+        return 1;
+    }
+    return 1 + (len - config.frame_length + config.hop - 1) / config.hop;
+}
+
+std::vector<float> StftFrames::makeWindow(WindowType type, size_t length) {
+    const double pi = std::acos(-1.0);
+    std::vector<float> w(length, 1.0f);
+    for (size_t i = 0; i < length; ++i) {
+        double phase = 2.0 * pi * static_cast<double>(i) / static_cast<double>(length);
+        if (type == WindowType::Hann) {
+            w[i] = static_cast<float>(0.5 - 0.5 * std::cos(phase));
+        } else if (type == WindowType::Hamming) {
+            w[i] = static_cast<float>(0.54 - 0.46 * std::cos(phase));
+        }
+    }
+    return w;
+}
+
+StftFrames::Frame StftFrames::frame(size_t k, int16_t* staging_out) const {
+    size_t length = config.frame_length;
+    Frame f;
+    f.index = k;
+    f.start = first + k * config.hop;
+    size_t range_end = first + count;
+    f.valid = f.start < range_end ? std::min(length, range_end - f.start) : 0;
+
+    // Borrow the segment's memory when the whole frame sits inside it
+    if (f.valid == length) {
+        size_t index = table->find(f.start);
+        if (index < table->segmentCount() && f.start + length <= table->starts[index + 1]) {
+            const SegmentDescriptor& segment = table->segments[index];
+            f.samples = table->buffers[segment.buffer]->data() + segment.offset + (f.start - table->starts[index]);
+            f.borrowed = true;
+            return f;
+        }
+    }
+
+    table->copyOut(staging_out, f.start, f.valid);
+    std::fill(staging_out + f.valid, staging_out + length, static_cast<int16_t>(0));
+    f.samples = staging_out;
+    f.borrowed = false;
+    return f;
+}
+
+bool StftFrames::next(Frame& out) {
+    if (cursor >= frames) {
+        return false;
+    }
+    out = frame(cursor++, staging.data());
+    return true;
+}
+
+void StftFrames::window(const Frame& f, float* out) const {
+    const float* w = coefficients.data();
+    for (size_t i = 0; i < config.frame_length; ++i) {
+        out[i] = static_cast<float>(f.samples[i]) * w[i];
+    }
+}
+
+// ========== Spectrogram Implementation ==========
+
+size_t Spectrogram::run(const SoundSegment& track, size_t start, size_t len, const StftConfig& config,
+                        float* out, const BlockVisitor* visit, Scheduler& scheduler) {
+    size_t fft_size = config.resolvedFftSize();
+    if (fft_size < config.frame_length) {
+        throw std::runtime_error("FFT size must be at least the frame length");
+    }
+    auto plan = FftPlan::get(fft_size);
+
+    StftFrames frames(track, start, len, config);
+    size_t total = frames.frameCount();
+    size_t columns = plan->bins();
+    size_t per_task = std::max<size_t>(config.frames_per_task, 1);
+    size_t blocks = (total + per_task - 1) / per_task;
+
+    scheduler.parallelFor(blocks, [&](size_t block) {
+        // Scratch for one block from the worker's arena, reused by each of
+        // its frames; the padding past frame_length stays zero
+        ScratchScope scratch;
+        int16_t* staging = scratch.allocateArray<int16_t>(config.frame_length);
+        float* windowed = scratch.allocateArray<float>(fft_size);
+        std::fill(windowed + config.frame_length, windowed + fft_size, 0.0f);
+        std::complex<float>* work = scratch.allocateArray<std::complex<float>>(plan->workSize());
+
+        size_t begin = block * per_task;
+        size_t end = std::min(total, begin + per_task);
+        float* rows = out ? out + begin * columns : scratch.allocateArray<float>((end - begin) * columns);
+
+        for (size_t k = begin; k < end; ++k) {
+            StftFrames::Frame f = frames.frame(k, staging);
+            frames.window(f, windowed);
+            plan->spectrum(windowed, rows + (k - begin) * columns, work, config.magnitude);
+        }
+        if (visit) {
+            (*visit)(begin, end - begin, rows);
+        }
+    });
+    return total;
+}
+
+size_t Spectrogram::compute(const SoundSegment& track, size_t start, size_t len, const StftConfig& config,
+                            float* out, Scheduler& scheduler) {
+    return run(track, start, len, config, out, nullptr, scheduler);
+}
+
+size_t Spectrogram::forEachBlock(const SoundSegment& track, size_t start, size_t len, const StftConfig& config,
+                                 const BlockVisitor& visit, Scheduler& scheduler) {
+    return run(track, start, len, config, nullptr, &visit, scheduler);
+}
+
+size_t Spectrogram::compute(const SoundSegment& track, size_t start, size_t len, const StftConfig& config,
+                            std::vector<float>& out, Scheduler& scheduler) {
+    size_t length_now = track.length();
+    size_t available = start < length_now ? std::min(len, length_now - start) : 0;
+    out.resize(StftFrames::frameCount(available, config) * bins(config));
+    size_t total = compute(track, start, available, config, out.data(), scheduler);
+    out.resize(total * bins(config));
+    return total;
+}
+
+}  // namespace AudioEditor
@@ -0,0 +1,127 @@
+#ifndef STFT_HPP
+#define STFT_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Fft.hpp"
+#include "SoundSegment.hpp"
+
+namespace AudioEditor {
+
+enum class WindowType {
+    Rectangular,
+    Hann,     // Periodic
+    Hamming   // Periodic
+};
+
+/**
+ * Framing and transform parameters. The defaults are 25 ms frames with a
+ * 10 ms hop at SAMPLE_RATE.
+ */
+struct StftConfig {
+    size_t frame_length = SAMPLE_RATE / 40;
+    size_t hop = SAMPLE_RATE / 100;
+    size_t fft_size = 0;           // 0 selects the next power of two >= frame_length
+    WindowType window = WindowType::Hann;
+    bool magnitude = false;        // Spectrogram holds |X| rather than |X|^2
+    size_t frames_per_task = 64;   // Frames transformed per scheduler task
+
+    size_t resolvedFftSize() const;
+};
+
+/**
+ * Frames of frame_length samples every hop samples over [start, start + len)
+ * of a track. A frame lying inside one segment is returned as a pointer
+ * into that segment's memory; others are gathered into caller or iterator
+ * staging, zero-padded past the end of the range. The last frame is the
+ * first one reaching the end, so every sample is covered.
+ *
+ * The track is read-locked while the frames object lives: writes to it
+ * wait, so do not write to the track from the same thread meanwhile.
+ * frame() is const and may be called from several threads with separate
+ * staging.
+ */
+class StftFrames {
+public:
+    struct Frame {
+        size_t index;            // Frame number
+        size_t start;            // Track position of the first sample
+        const int16_t* samples;  // frame_length samples
+        size_t valid;            // Samples from the track; the rest are zero padding
+        bool borrowed;           // samples points into segment memory
+    };
+
+private:
+    StftConfig config;
+    size_t first;
+    size_t count;
+    size_t frames;
+    RangeLock lock;
+    std::shared_ptr<const SegmentTable> table;
+    std::vector<float> coefficients;  // Window, pre-scaled to map int16 onto [-1, 1)
+    std::vector<int16_t> staging;     // Used by next()
+    size_t cursor;
+
+public:
+    StftFrames(const SoundSegment& track, size_t start, size_t len, const StftConfig& config = StftConfig());
+
+    StftFrames(const StftFrames&) = delete;
+    StftFrames& operator=(const StftFrames&) = delete;
+
+    size_t frameCount() const { return frames; }
+    size_t frameLength() const { return config.frame_length; }
+    const StftConfig& settings() const { return config; }
+
+    // Frame k; staging must hold frameLength() samples and is only written
+    // when the frame cannot be borrowed
+    Frame frame(size_t k, int16_t* staging_out) const;
+
+    // Sequential access using internal staging; false after the last frame
+    bool next(Frame& out);
+    void reset() { cursor = 0; }
+
+    // Apply the window to a frame, writing frameLength() floats
+    void window(const Frame& frame, float* out) const;
+
+    static size_t frameCount(size_t len, const StftConfig& config);
+    static std::vector<float> makeWindow(WindowType type, size_t length);
+};
+
+/**
+ * Batched short-time Fourier transform of a track into a caller-provided
+ * matrix. Frames are split into blocks of frames_per_task, and blocks run
+ * on the scheduler (and the calling thread), each reusing one set of
+ * scratch buffers from the thread's ScratchArena and the shared FFT plan
+ * for all of its frames.
+ */
+class Spectrogram {
+public:
+    // Called once per block with frames rows of bins() values, starting at first_frame
+    using BlockVisitor = std::function<void(size_t first_frame, size_t frames, const float* spectra)>;
+
+    // Columns of the output matrix
+    static size_t bins(const StftConfig& config) { return config.resolvedFftSize() / 2 + 1; }
+
+    // Write frameCount x bins floats, row-major, to out; returns the frame count
+    static size_t compute(const SoundSegment& track, size_t start, size_t len, const StftConfig& config,
+                          float* out, Scheduler& scheduler = Scheduler::instance());
+    static size_t compute(const SoundSegment& track, size_t start, size_t len, const StftConfig& config,
+                          std::vector<float>& out, Scheduler& scheduler = Scheduler::instance());
+
+    // Hand each block's spectra to visit instead of storing them; visit runs
+    // concurrently for different blocks. Returns the frame count.
+    static size_t forEachBlock(const SoundSegment& track, size_t start, size_t len, const StftConfig& config,
+                               const BlockVisitor& visit, Scheduler& scheduler = Scheduler::instance());
+
+private:
+    static size_t run(const SoundSegment& track, size_t start, size_t len, const StftConfig& config,
+                      float* out, const BlockVisitor* visit, Scheduler& scheduler);
+};
+
+}  // namespace AudioEditor
+
+#endif  // STFT_HPP
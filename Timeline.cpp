@@ -0,0 +1,161 @@
+#include "Timeline.hpp"
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace AudioEditor {
+
+namespace {
+
+// Chain of len zeros over one buffer; every chunk reads the same samples
+std::shared_ptr<SegmentNode> silentChain(const std::shared_ptr<SampleBuffer>& zeros, size_t len,
+                                         std::shared_ptr<SegmentNode>& last) {
+    std::shared_ptr<SegmentNode> first;
+    last = nullptr;
+    while (len > 0) {
+        size_t chunk = std::min(len, zeros->size());
+        auto node = std::make_shared<SegmentNode>(zeros, 0, chunk);
+        if (last) {
+            last->next = node;
+        } else {
+            first = node;
+        }
+        last = node;
+        len -= chunk;
+    }
+    return first;
+}
+
+}  // namespace
+
+size_t Timeline::addTrack(SoundSegment& track) {
+    if (std::find(tracks.begin(), tracks.end(), &track) != tracks.end()) {
+        throw std::runtime_error("Track is already on the timeline");
+    }
+    tracks.push_back(&track);
+    return tracks.size() - 1;
+}
+
+void Timeline::removeTrack(size_t index) {
+    if (index >= tracks.size()) {
+        throw std::runtime_error("Track index out of range");
+    }
+    tracks.erase(tracks.begin() + index);
+}
+
+SoundSegment& Timeline::track(size_t index) const {
+    if (index >= tracks.size()) {
+        throw std::runtime_error("Track index out of range");
+    }
+    return *tracks[index];
+}
+
+size_t Timeline::length() const {
+    size_t longest = 0;
+    for (const SoundSegment* member : tracks) {
+        longest = std::max(longest, member->length());
+    }
+    return longest;
+}
+
+std::vector<SoundSegment*> Timeline::lockOrder() const {
+    std::vector<SoundSegment*> ordered(tracks);
+    std::sort(ordered.begin(), ordered.end(), std::less<SoundSegment*>());
+    return ordered;
+}
+
+std::vector<RangeLock> Timeline::lockTracks(const std::vector<SoundSegment*>& ordered, size_t pos) {
+    // Buffered writes refer to positions the edit is about to shift
+    for (SoundSegment* member : ordered) {
+        member->flushWrites();
+    }
+    std::vector<RangeLock> held;
+    held.reserve(ordered.size());
+    for (SoundSegment* member : ordered) {
+        held.push_back(member->lockStructure(pos));
+    }
+    return held;
+}
+
+void Timeline::rippleDelete(size_t pos, size_t len) {
+    if (len == 0) return;
+
+    auto ordered = lockOrder();
+    auto held = lockTracks(ordered, pos);
+
+    // Cut chains are dropped after the locks, so freeing buffers does not
+    // hold up readers
+    std::vector<std::shared_ptr<SegmentNode>> removed;
+    for (SoundSegment* member : ordered) {
+        size_t member_length = member->total_length;
+        if (pos >= member_length) {
+            continue;
+        }
+        std::shared_ptr<SegmentNode> last;
+        removed.push_back(member->detachRange(pos, std::min(len, member_length - pos), last));
+    }
+    held.clear();
+}
+
+void Timeline::rippleInsert(size_t pos, size_t len) {
+    if (len == 0) return;
+
+    auto zeros = SampleBuffer::allocate(std::min(len, SEGMENT_MAX_LENGTH));
+    zeros->markShared();
+
+    auto ordered = lockOrder();
+    auto held = lockTracks(ordered, pos);
+
+    for (SoundSegment* member : ordered) {
+        if (pos > member->total_length) {
+            continue;
+        }
+        std::shared_ptr<SegmentNode> last;
+        auto first = silentChain(zeros, len, last);
+        member->spliceIn(pos, first, last);
+    }
+}
+
+void Timeline::rippleInsert(size_t pos, size_t target, const SoundSegment& clip) {
+    SoundSegment* target_track = &track(target);
+
+    // Take the clip's segments before locking the timeline; the clip may
+    // itself be a member
+    std::shared_ptr<SegmentNode> clip_first;
+    std::shared_ptr<SegmentNode> clip_last;
+    size_t len;
+    clip.flushWrites();
+    {
+        RangeLock lock(*clip.locks, 0, RANGE_LOCK_END, RangeLockMode::Shared);
+        len = clip.total_length;
+        auto cursor = clip.head;
+        clip_first = clip.shareSegments(cursor, 0, len, clip_last);
+    }
+    if (len == 0) return;
+
+    auto ordered = lockOrder();
+    auto held = lockTracks(ordered, pos);
+
+    // A target ending before pos is padded with silence, so the clip lands
+    // at pos like the other members' gaps
+    size_t pad = pos > target_track->total_length ? pos - target_track->total_length : 0;
+    auto zeros = SampleBuffer::allocate(std::min(std::max(len, pad), SEGMENT_MAX_LENGTH));
+    zeros->markShared();
+
+    for (SoundSegment* member : ordered) {
+        if (member == target_track) {
+            if (pad > 0) {
+                std::shared_ptr<SegmentNode> last;
+                auto first = silentChain(zeros, pad, last);
+                member->spliceIn(member->total_length, first, last);
+            }
+            member->spliceIn(pos, clip_first, clip_last);
+        } else if (pos <= member->total_length) {
+            std::shared_ptr<SegmentNode> last;
+            auto first = silentChain(zeros, len, last);
+            member->spliceIn(pos, first, last);
+        }
+    }
+}
+
+}  // namespace AudioEditor
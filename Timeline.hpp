@@ -0,0 +1,64 @@
+#ifndef TIMELINE_HPP
+#define TIMELINE_HPP
+
+#include <stddef.h>
+#include <vector>
+
+#include "SoundSegment.hpp"
+
+namespace AudioEditor {
+
+/**
+ * Tracks edited against a shared time axis (voice, music, ads, ...).
+ * Ripple edits apply to every member in one coordinated pass: writes are
+ * flushed and every track is locked up front (in a fixed order, so two
+ * timelines sharing tracks cannot deadlock), then each track is cut or
+ * spliced once. Readers of any member see either all of an edit or none.
+ *
+ * Gaps are zeros from one buffer shared by every track, allocated once
+ * per edit; writing into a gap later copies just the touched blocks.
+ *
+ * Tracks are not owned and must outlive the timeline. A track shorter
+ * than an edit position has nothing after it to shift and is left alone.
+ */
+class Timeline {
+private:
+    std::vector<SoundSegment*> tracks;  // In the order they were added
+
+    // Members sorted by address, the order their locks are taken in
+    std::vector<SoundSegment*> lockOrder() const;
+
+    // Flush and take the structural lock at pos on each of ordered
+    static std::vector<RangeLock> lockTracks(const std::vector<SoundSegment*>& ordered, size_t pos);
+
+public:
+    Timeline() = default;
+
+    Timeline(const Timeline&) = delete;
+    Timeline& operator=(const Timeline&) = delete;
+
+    // Add a track; returns its index. A track may only be added once.
+    size_t addTrack(SoundSegment& track);
+    void removeTrack(size_t index);
+
+    size_t trackCount() const { return tracks.size(); }
+    SoundSegment& track(size_t index) const;
+
+    // Length of the longest member
+    size_t length() const;
+
+    // Remove [pos, pos + len) from every track, shifting later material left
+    void rippleDelete(size_t pos, size_t len);
+
+    // Open a silent gap of len samples at pos in every track
+    void rippleInsert(size_t pos, size_t len);
+
+    // Insert clip into one track at pos (sharing its buffers) and a gap of
+    // the same length into the others, so everything after pos stays in sync.
+    // A target shorter than pos is first padded with silence up to pos.
+    void rippleInsert(size_t pos, size_t target, const SoundSegment& clip);
+};
+
+}  // namespace AudioEditor
+
+#endif  // TIMELINE_HPP
@@ -0,0 +1,52 @@
+#include "TrackBuilder.hpp"
+#include <stdexcept>
+
+namespace AudioEditor {
+
+void TrackBuilder::link(const SoundSegment& track, size_t pos, size_t len) {
+    if (len == 0) {
+        return;
+    }
+
+    auto cursor = track.head;
+    std::shared_ptr<SegmentNode> chain_last;
+    auto chain = track.shareSegments(cursor, pos, len, chain_last);
+    if (last) {
+        last->next = chain;
+    } else {
+        first = chain;
+    }
+    last = chain_last;
+    total += len;
+}
+
+TrackBuilder& TrackBuilder::append(const SoundSegment& track) {
+    track.flushWrites();
+    RangeLock lock(*track.locks, 0, RANGE_LOCK_END, RangeLockMode::Shared);
+    link(track, 0, track.total_length);
+    return *this;
+}
+
+TrackBuilder& TrackBuilder::append(const SoundSegment& track, size_t pos, size_t len) {
+    track.flushWrites();
+    RangeLock lock(*track.locks, pos, RANGE_LOCK_END, RangeLockMode::Shared);
+    if (len > track.total_length || pos > track.total_length - len) {
+        throw std::runtime_error("Range is outside the source track");
+    }
+    link(track, pos, len);
+    return *this;
+}
+
+std::unique_ptr<SoundSegment> TrackBuilder::build() {
+    auto track = SoundSegment::create();
+    track->head = std::move(first);
+    // Each appended chain was numbered from zero; one pass fixes them all
+    track->updateGlobalIndices();
+
+    first = nullptr;
+    last = nullptr;
+    total = 0;
+    return track;
+}
+
+}  // namespace AudioEditor
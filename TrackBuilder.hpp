@@ -0,0 +1,48 @@
+#ifndef TRACK_BUILDER_HPP
+#define TRACK_BUILDER_HPP
+
+#include <stddef.h>
+#include <memory>
+
+#include "SoundSegment.hpp"
+
+namespace AudioEditor {
+
+/**
+ * Assembles a new track from ranges of existing tracks without copying
+ * samples. Each append walks only the source's segments and links nodes
+ * over the source buffers onto the end of the chain being built, so k
+ * clips cost one pass over their segments plus a single renumbering in
+ * build(), rather than k tail walks and k reindexes.
+ *
+ * Sources are left unchanged; their buffers become shared, so later
+ * writes to either side copy the affected blocks first.
+ */
+class TrackBuilder {
+private:
+    std::shared_ptr<SegmentNode> first;  // Chain built so far
+    std::shared_ptr<SegmentNode> last;
+    size_t total;
+
+    // Link nodes for [pos, pos + len) of track; the caller holds its lock
+    void link(const SoundSegment& track, size_t pos, size_t len);
+
+public:
+    TrackBuilder() : total(0) {}
+
+    TrackBuilder(const TrackBuilder&) = delete;
+    TrackBuilder& operator=(const TrackBuilder&) = delete;
+
+    // Append the whole of track, or [pos, pos + len) of it
+    TrackBuilder& append(const SoundSegment& track);
+    TrackBuilder& append(const SoundSegment& track, size_t pos, size_t len);
+
+    size_t length() const { return total; }
+
+    // Hand the chain to a new track; the builder is empty afterwards
+    std::unique_ptr<SoundSegment> build();
+};
+
+}  // namespace AudioEditor
+
+#endif  // TRACK_BUILDER_HPP
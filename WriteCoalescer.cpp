@@ -0,0 +1,106 @@
+#include "WriteCoalescer.hpp"
+#include <algorithm>
+#include <iterator>
+
+namespace AudioEditor {
+
+size_t WriteCoalescer::add(const int16_t* src, size_t pos, size_t len) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    size_t start = pos;
+    size_t end = pos + len;
+
+    // First run that overlaps or touches [start, end]
+    auto first = runs.upper_bound(start);
+    if (first != runs.begin()) {
+        auto before = std::prev(first);
+        if (before->first + before->second.size() >= start) {
+            first = before;
+        }
+    }
+
+    auto last = first;
+    size_t merged_start = start;
+    size_t merged_end = end;
+    while (last != runs.end() && last->first <= end) {
+        merged_start = std::min(merged_start, last->first);
+        merged_end = std::max(merged_end, last->first + last->second.size());
+        ++last;
+    }
+
+    if (first == last) {
+        runs.emplace(start, std::vector<int16_t>(src, src + len));
+        pending += len;
+        return pending;
+    }
+
+    // Appending to the end of one run is the common case; grow it in place
+    if (std::next(first) == last && first->first == merged_start &&
+        first->first + first->second.size() == start) {
+        first->second.insert(first->second.end(), src, src + len);
+        pending += len;
+        return pending;
+    }
+
+    std::vector<int16_t> merged(merged_end - merged_start);
+    for (auto run = first; run != last; ++run) {
+        std::copy(run->second.begin(), run->second.end(), merged.begin() + (run->first - merged_start));
+        pending -= run->second.size();
+    }
+    std::copy(src, src + len, merged.begin() + (start - merged_start));
+
+    runs.erase(first, last);
+    pending += merged.size();
+    runs.emplace(merged_start, std::move(merged));
+    return pending;
+}
+
+size_t WriteCoalescer::runCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return runs.size();
+}
+
+bool WriteCoalescer::overlaps(size_t start, size_t len) const {
+    if ((empty() && !applying.load(std::memory_order_acquire)) || len == 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t end = len > SIZE_MAX - start ? SIZE_MAX : start + len;
+    if (applying.load(std::memory_order_relaxed) && taken_start < end && taken_end > start) {
+        return true;
+    }
+
+    // Only the last run starting before end can reach into the range
+    auto it = runs.lower_bound(end);
+    if (it == runs.begin()) {
+        return false;
+    }
+    --it;
+    return it->first + it->second.size() > start;
+}
+
+std::vector<WriteCoalescer::Run> WriteCoalescer::take() {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::vector<Run> taken;
+    taken.reserve(runs.size());
+    for (auto& entry : runs) {
+        taken.push_back(Run{entry.first, std::move(entry.second)});
+    }
+    runs.clear();
+    pending = 0;
+    if (!taken.empty()) {
+        taken_start = taken.front().pos;
+        taken_end = taken.back().pos + taken.back().samples.size();
+        applying.store(true, std::memory_order_release);
+    }
+    return taken;
+}
+
+void WriteCoalescer::applied() {
+    std::lock_guard<std::mutex> lock(mutex);
+    applying.store(false, std::memory_order_release);
+}
+
+}  // namespace AudioEditor
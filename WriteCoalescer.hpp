@@ -0,0 +1,69 @@
+#ifndef WRITE_COALESCER_HPP
+#define WRITE_COALESCER_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace AudioEditor {
+
+// Writes of at most this many samples are held back while coalescing
+constexpr size_t COALESCE_MAX_WRITE = 1024;
+// Buffered samples that force a flush
+constexpr size_t COALESCE_MAX_PENDING = 1 << 20;
+
+/**
+ * Pending small writes for one track, kept as sorted, disjoint runs.
+ * Overlapping and adjacent writes merge into one run (later samples win),
+ * so thousands of tiny writes flush as a few runs applied in one ordered
+ * pass over the segments.
+ */
+class WriteCoalescer {
+public:
+    struct Run {
+        size_t pos;
+        std::vector<int16_t> samples;
+    };
+
+private:
+    mutable std::mutex mutex;
+    std::map<size_t, std::vector<int16_t>> runs;  // Keyed by start position
+    std::atomic<size_t> pending;                  // Samples across all runs
+    std::mutex flushing;                          // Held while runs are being applied
+    std::atomic<bool> applying;                   // Runs were taken and are not yet applied
+    size_t taken_start;                           // Span of the taken runs, valid while applying
+    size_t taken_end;
+
+public:
+    WriteCoalescer() : pending(0), applying(false), taken_start(0), taken_end(0) {}
+
+    WriteCoalescer(const WriteCoalescer&) = delete;
+    WriteCoalescer& operator=(const WriteCoalescer&) = delete;
+
+    // Buffer a write; returns the number of samples now pending
+    size_t add(const int16_t* src, size_t pos, size_t len);
+
+    bool empty() const { return pending.load(std::memory_order_acquire) == 0; }
+    size_t pendingSamples() const { return pending.load(std::memory_order_acquire); }
+    size_t runCount() const;
+
+    // True if any pending run, or the span of runs taken by a flush still
+    // in progress, overlaps [start, start + len)
+    bool overlaps(size_t start, size_t len) const;
+
+    // Remove and return every run, in ascending position order. Their span
+    // keeps reporting as overlapping until applied() is called.
+    std::vector<Run> take();
+    void applied();
+
+    // Serialises flushes; a reader that overlaps a flush in progress waits
+    // here, so it never sees runs that were taken but not yet applied
+    std::unique_lock<std::mutex> lockFlush() { return std::unique_lock<std::mutex>(flushing); }
+};
+
+}  // namespace AudioEditor
+
+#endif  // WRITE_COALESCER_HPP
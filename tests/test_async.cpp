@@ -0,0 +1,181 @@
+#include "../SoundSegment.hpp"
+#include "../Coroutines.hpp"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdio>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <chrono>
+#include <thread>
+
+using namespace AudioEditor;
+
+// Simple assertion macro for testing
+#define ASSERT(condition, message) \
+    if (!(condition)) { \
+        std::cerr << "ASSERTION FAILED: " << message << " at line " << __LINE__ << std::endl; \
+        return false; \
+    }
+
+// Minimal eagerly-started coroutine whose completion is observed through a future
+struct DetachedTask {
+    struct promise_type {
+        std::promise<void> done;
+
+        DetachedTask get_return_object() { return DetachedTask{done.get_future()}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() { done.set_value(); }
+        void unhandled_exception() { done.set_exception(std::current_exception()); }
+    };
+
+    std::future<void> finished;
+};
+
+DetachedTask roundTrip(const std::vector<int16_t>& data, std::vector<int16_t>& loaded_out,
+                       std::string& hits_out) {
+    auto track = SoundSegment::create();
+    track->write(data, 0);
+    co_await track->saveAsync("test_async.wav");
+
+    auto loaded = SoundSegment::create();
+    co_await loaded->loadAsync("test_async.wav");
+    loaded_out = loaded->getAllSamples();
+
+    auto ad = SoundSegment::create();
+    ad->write(std::vector<int16_t>{10, 20, 30}, 0);
+    hits_out = co_await loaded->identifyAsync(*ad);
+}
+
+DetachedTask cancelledIdentify(bool& threw) {
+    auto target = SoundSegment::create();
+    target->write(std::vector<int16_t>(1000, 5), 0);
+    auto ad = SoundSegment::create();
+    ad->write(std::vector<int16_t>{1, 2}, 0);
+
+    CancellationToken token;
+    token.cancel();
+    try {
+        co_await target->identifyAsync(*ad, OperationControl().withToken(token));
+    } catch (const OperationCancelled&) {
+        threw = true;
+    }
+}
+
+bool test_coroutine_round_trip() {
+    std::cout << "Testing co_await on save/load/identify..." << std::endl;
+
+    std::vector<int16_t> data = {1, 2, 3, 10, 20, 30, 4, 5, 6, 10, 20, 30, 7, 8, 9};
+    std::vector<int16_t> loaded;
+    std::string hits;
+
+    roundTrip(data, loaded, hits).finished.get();
+    std::remove("test_async.wav");
+
+    ASSERT(loaded == data, "Async load should return the saved samples");
+    ASSERT(hits == "3,5\n9,11", "Async identify should match the synchronous result");
+
+    std::cout << "✓ Coroutine round trip test passed" << std::endl;
+    return true;
+}
+
+bool test_coroutine_errors() {
+    std::cout << "Testing exceptions propagate through co_await..." << std::endl;
+
+    bool threw = false;
+    cancelledIdentify(threw).finished.get();
+    ASSERT(threw, "Cancellation should surface as an exception at the co_await");
+
+    std::cout << "✓ Coroutine error propagation test passed" << std::endl;
+    return true;
+}
+
+bool test_many_concurrent_operations() {
+    std::cout << "Testing many concurrent async operations..." << std::endl;
+
+    auto target = SoundSegment::create();
+    std::vector<int16_t> data(4000, 0);
+    data[1000] = 100; data[1001] = 200;
+    target->write(data, 0);
+    auto ad = SoundSegment::create();
+    ad->write(std::vector<int16_t>{100, 200}, 0);
+
+    std::vector<AsyncOperation<std::string>> ops;
+    for (int i = 0; i < 200; ++i) {
+        ops.push_back(target->identifyAsync(*ad));
+    }
+
+    std::atomic<int> callbacks(0);
+    for (auto& op : ops) {
+        op.onComplete([&callbacks]() { ++callbacks; });
+    }
+    for (auto& op : ops) {
+        ASSERT(op.get() == "1000,1001", "Each async identify should find the pattern");
+    }
+    // Callbacks run on the workers right after completion is published
+    auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (callbacks.load() < 200 && std::chrono::steady_clock::now() < give_up) {
+        std::this_thread::yield();
+    }
+    ASSERT(callbacks.load() == 200, "Every completion callback should run");
+
+    std::cout << "✓ Concurrent async operations test passed" << std::endl;
+    return true;
+}
+
+bool test_operation_without_state() {
+    std::cout << "Testing empty and moved-from async operations..." << std::endl;
+
+    AsyncOperation<std::string> empty;
+    ASSERT(!empty.valid(), "Default-constructed operation has no state");
+
+    auto expectNoState = [](const std::function<void()>& call) {
+        try {
+            call();
+        } catch (const std::future_error& e) {
+            return e.code() == std::future_errc::no_state;
+        }
+        return false;
+    };
+    ASSERT(expectNoState([&]() { empty.ready(); }), "ready() without state should throw no_state");
+    ASSERT(expectNoState([&]() { empty.wait(); }), "wait() without state should throw no_state");
+    ASSERT(expectNoState([&]() { empty.get(); }), "get() without state should throw no_state");
+    ASSERT(expectNoState([&]() { empty.onComplete([]() {}); }), "onComplete() without state should throw no_state");
+
+    auto target = SoundSegment::create();
+    target->write(std::vector<int16_t>(100, 1), 0);
+    auto ad = SoundSegment::create();
+    ad->write(std::vector<int16_t>{1}, 0);
+    AsyncOperation<std::string> source = target->identifyAsync(*ad);
+    AsyncOperation<std::string> moved = std::move(source);
+    ASSERT(!source.valid() && moved.valid(), "Moving should transfer the state");
+    ASSERT(expectNoState([&]() { source.tryOnComplete([]() {}); }), "Moved-from operation should throw no_state");
+    moved.get();
+
+    std::cout << "✓ Stateless async operation test passed" << std::endl;
+    return true;
+}
+
+int main() {
+    std::cout << "C++ Audio Editor Async Test Suite" << std::endl;
+    std::cout << "=================================" << std::endl;
+
+    bool all_passed = true;
+
+    all_passed &= test_coroutine_round_trip();
+    all_passed &= test_coroutine_errors();
+    all_passed &= test_many_concurrent_operations();
+    all_passed &= test_operation_without_state();
+
+    std::cout << std::endl;
+    if (all_passed) {
+        std::cout << "✓ All tests passed!" << std::endl;
+        return 0;
+    } else {
+        std::cout << "✗ Some tests failed!" << std::endl;
+        return 1;
+    }
+}
@@ -1,9 +1,22 @@
 #include "../SoundSegment.hpp"
+#include "../ScratchArena.hpp"
+#include "../Numa.hpp"
+#include "../MemoryPressure.hpp"
+#include "../TrackBuilder.hpp"
+#include "../Timeline.hpp"
+#include "../Stft.hpp"
+#include "../MelFeatures.hpp"
 #include <iostream>
 #include <vector>
 #include <cassert>
+#include <algorithm>
 #include <string>
 #include <cmath>
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
 
 using namespace AudioEditor;
 
@@ -198,11 +211,1711 @@ bool test_edge_cases() {
     auto samples = empty_track->getAllSamples();
     ASSERT(samples[5] == 1 && samples[6] == 2 && samples[7] == 3, 
            "Data should be written at correct position");
+
+    // Vector reads return only the samples that exist: a read running off
+    // the end is shortened, one starting at or past the end is empty
+    std::vector<int16_t> tail(4, 9);
+    empty_track->read(tail, 6, 10);
+    ASSERT(tail == std::vector<int16_t>({2, 3}), "Read past the end should be clamped to the track");
+    empty_track->read(tail, 8, 10);
+    ASSERT(tail.empty(), "Read starting at the end should be empty");
+    empty_track->read(tail, 100, 10);
+    ASSERT(tail.empty(), "Read starting past the end should be empty");
+    std::vector<float> tail_float;
+    empty_track->read(tail_float, 7, 10);
+    ASSERT(tail_float.size() == 1, "Converted reads should be clamped the same way");
     
     std::cout << "✓ Edge cases test passed" << std::endl;
     return true;
 }
 
+bool test_operation_control() {
+    std::cout << "Testing cancellation, deadlines and progress..." << std::endl;
+
+    auto target = SoundSegment::create();
+    std::vector<int16_t> target_data(20000);
+    for (size_t i = 0; i < target_data.size(); ++i) {
+        target_data[i] = static_cast<int16_t>((i * 37) % 200);
+    }
+    target->write(target_data, 0);
+
+    auto ad = SoundSegment::create();
+    ad->write(std::vector<int16_t>{10, 20, 30, 40}, 0);
+
+    // Cancelled token aborts before any work is done
+    CancellationToken token;
+    token.cancel();
+    bool cancelled = false;
+    try {
+        target->identify(*ad, OperationControl().withToken(token));
+    } catch (const OperationCancelled&) {
+        cancelled = true;
+    }
+    ASSERT(cancelled, "Cancelled identify should throw OperationCancelled");
+
+    // Deadline in the past aborts with DeadlineExceeded
+    bool expired = false;
+    try {
+        target->identify(*ad, OperationControl().withDeadline(OperationControl::Clock::now()));
+    } catch (const DeadlineExceeded&) {
+        expired = true;
+    }
+    ASSERT(expired, "Expired deadline should throw DeadlineExceeded");
+
+    // Progress is reported per block and finishes at the total
+    OperationControl control;
+    control.block_size = 1024;
+    size_t calls = 0;
+    size_t last = 0;
+    size_t last_total = 0;
+    control.withProgress([&](size_t done, size_t total) {
+        ++calls;
+        last = done;
+        last_total = total;
+    });
+    std::string with_control = target->identify(*ad, control);
+    ASSERT(with_control == target->identify(*ad), "Controlled identify should match plain identify");
+    ASSERT(calls > 1 && last == last_total, "Progress should be reported up to completion");
+
+    // Aborted save removes the partial file; aborted load leaves the track untouched
+    bool save_aborted = false;
+    try {
+        target->saveToWav("test_cancel.wav", OperationControl().withToken(token));
+    } catch (const OperationAborted&) {
+        save_aborted = true;
+    }
+    ASSERT(save_aborted, "Cancelled save should throw");
+    ASSERT(fopen("test_cancel.wav", "rb") == nullptr, "Cancelled save should not leave a file");
+
+    target->saveToWav("test_cancel.wav", control);
+    auto loaded = SoundSegment::create();
+    bool load_aborted = false;
+    try {
+        loaded->loadFromWav("test_cancel.wav", OperationControl().withToken(token));
+    } catch (const OperationAborted&) {
+        load_aborted = true;
+    }
+    ASSERT(load_aborted && loaded->length() == 0, "Cancelled load should leave the track empty");
+    loaded->loadFromWav("test_cancel.wav", control);
+    ASSERT(loaded->getAllSamples() == target_data, "Blocked save/load should round-trip");
+    std::remove("test_cancel.wav");
+
+    std::cout << "✓ Operation control test passed" << std::endl;
+    return true;
+}
+
+bool test_scratch_arena() {
+    std::cout << "Testing per-thread scratch arenas..." << std::endl;
+
+    // Nested scopes rewind to their own marker
+    ScratchArena& arena = ScratchArena::local();
+    {
+        ScratchScope outer;
+        int16_t* a = outer.allocateArray<int16_t>(100);
+        {
+            ScratchScope inner;
+            int16_t* b = inner.allocateArray<int16_t>(100);
+            ASSERT(b != a, "Inner allocation should not alias outer allocation");
+        }
+        int16_t* c = outer.allocateArray<int16_t>(100);
+        {
+            ScratchScope inner;
+            ASSERT(inner.allocateArray<int16_t>(100) != c, "Rewound arena should reuse memory past the marker");
+        }
+    }
+
+    auto target = SoundSegment::create();
+    std::vector<int16_t> target_data(200000, 3);
+    target_data[150000] = 1000;
+    target_data[150001] = -1000;
+    target->write(target_data, 0);
+    auto ad = SoundSegment::create();
+    ad->write(std::vector<int16_t>{1000, -1000}, 0);
+
+    // First call may grow the arena; identical calls afterwards must not
+    std::string first = target->identify(*ad);
+    size_t allocations = arena.blockAllocations();
+    std::string second = target->identify(*ad);
+    std::string third = target->identify(*ad);
+    ASSERT(first == "150000,150001" && second == first && third == first,
+           "identify should be unaffected by scratch memory reuse");
+    ASSERT(arena.blockAllocations() == allocations, "Steady-state identify should not grow the arena");
+
+    // A one-off pass over a long track must not stay pinned on the thread
+    auto long_track = SoundSegment::create();
+    long_track->write(std::vector<int16_t>(SCRATCH_MAX_RETAINED_SIZE, 3), 0);
+    long_track->write(std::vector<int16_t>{1000, -1000}, 123456);
+    ASSERT(long_track->identify(*ad) == "123456,123457", "identify over a long track should find the ad");
+    ASSERT(arena.capacity() <= SCRATCH_MAX_RETAINED_SIZE, "Oversized scratch peaks should be freed on reset");
+    ASSERT(target->identify(*ad) == first, "identify should still work after the arena is freed");
+
+    std::cout << "✓ Scratch arena test passed" << std::endl;
+    return true;
+}
+
+bool test_numa_placement() {
+    std::cout << "Testing NUMA-aware buffers and scheduling..." << std::endl;
+
+    const NumaTopology& topology = NumaTopology::instance();
+    ASSERT(topology.nodeCount() >= 1, "There is always at least one node");
+
+    // Small and large buffers are zero-initialised under every placement
+    auto small = SampleBuffer::allocate(16);
+    auto large = SampleBuffer::allocate(1 << 20, BufferPlacement::Interleaved);
+    ASSERT(small->size() == 16 && large->size() == (1 << 20), "Buffers should have the requested size");
+    ASSERT(small->data()[15] == 0 && large->data()[(1 << 20) - 1] == 0, "Buffers should be zeroed");
+
+    // Placement only applies on multi-node machines; elsewhere every buffer
+    // is ordinary heap memory on node 0
+    size_t placed_count = NUMA_PLACEMENT_MIN_BYTES / sizeof(int16_t);
+    if (!topology.isNuma()) {
+        auto placed = SampleBuffer::allocate(placed_count, BufferPlacement::LocalNode);
+        ASSERT(small->node() == 0 && placed->node() == 0 && large->node() == 0,
+               "Single-node buffers should report node 0");
+        ASSERT(!placed->isMapped() && !large->isMapped(), "Single-node buffers should not be mapped");
+    }
+
+    auto track = SoundSegment::create();
+    ASSERT(track->preferredNode() == -1, "Empty track has no preferred node");
+    track->write(std::vector<int16_t>(1000, 1), 0);
+    int node = track->preferredNode();
+    ASSERT(node >= 0 && static_cast<size_t>(node) < topology.nodeCount(), "Track should report a valid node");
+
+    // Hinted tasks run on some worker even when the hint cannot be honoured
+    Scheduler scheduler(2);
+    std::atomic<int> ran(0);
+    std::atomic<int> bad_node(0);
+    for (int i = 0; i < 50; ++i) {
+        scheduler.submit([&]() {
+            int n = Scheduler::currentWorkerNode();
+            if (n < 0 || static_cast<size_t>(n) >= topology.nodeCount()) ++bad_node;
+            ++ran;
+        }, i % 3 - 1);
+    }
+    auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (ran.load() < 50 && std::chrono::steady_clock::now() < give_up) {
+        std::this_thread::yield();
+    }
+    ASSERT(ran.load() == 50, "All hinted tasks should run");
+    ASSERT(bad_node.load() == 0, "Tasks should run on scheduler workers");
+    ASSERT(Scheduler::currentWorkerNode() == -1, "Test thread is not a worker");
+
+    // On NUMA hosts a placed buffer allocated by a pinned worker is mapped
+    // and its pages land on that worker's node
+    if (topology.isNuma()) {
+        std::atomic<int> misplaced(0);
+        std::atomic<int> placed_tasks(0);
+        for (size_t n = 0; n < topology.nodeCount(); ++n) {
+            scheduler.submit([&]() {
+                int worker = Scheduler::currentWorkerNode();
+                auto placed = SampleBuffer::allocate(placed_count, BufferPlacement::LocalNode);
+                placed->data()[0] = 1;
+                if (!placed->isMapped() || placed->node() != worker ||
+                    topology.nodeOfAddress(placed->data()) != worker) {
+                    ++misplaced;
+                }
+                ++placed_tasks;
+            }, static_cast<int>(n));
+        }
+        give_up = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (placed_tasks.load() < static_cast<int>(topology.nodeCount()) &&
+               std::chrono::steady_clock::now() < give_up) {
+            std::this_thread::yield();
+        }
+        ASSERT(placed_tasks.load() == static_cast<int>(topology.nodeCount()), "Placement tasks should run");
+        ASSERT(misplaced.load() == 0, "Placed buffers should land on the allocating worker's node");
+    }
+
+    std::cout << "✓ NUMA placement test passed" << std::endl;
+    return true;
+}
+
+bool test_memory_pressure() {
+    std::cout << "Testing memory-pressure cache trimming..." << std::endl;
+
+    MemoryPressureMonitor& monitor = MemoryPressureMonitor::instance();
+
+    // Real readings must at least be internally consistent
+    MemoryPressureSample system = MemoryPressureMonitor::readSystem();
+    ASSERT(system.limit_bytes == 0 || system.usage_bytes <= system.limit_bytes * 2,
+           "System reading should be plausible");
+
+    MemoryPressureSample fake;
+    fake.limit_bytes = 1000;
+    fake.usage_bytes = 500;
+    monitor.setProbe([&fake]() { return fake; });
+
+    std::atomic<int> trims(0);
+    MemoryPressureLevel seen = MemoryPressureLevel::Normal;
+    size_t cache_id = monitor.registerCache([&trims](MemoryPressureLevel) {
+        ++trims;
+        return size_t(100);
+    });
+    size_t listener_id = monitor.addListener([&seen](MemoryPressureLevel level, const MemoryPressureSample&) {
+        seen = level;
+    });
+
+    ASSERT(monitor.poll() == MemoryPressureLevel::Normal && trims == 0, "Low usage should not trim");
+
+    fake.usage_bytes = 850;
+    ASSERT(monitor.poll() == MemoryPressureLevel::Moderate, "80%+ usage is moderate pressure");
+    ASSERT(trims == 1 && seen == MemoryPressureLevel::Moderate, "Moderate pressure trims and notifies");
+
+    fake.usage_bytes = 500;
+    fake.psi_some_avg10 = 55.0;
+    ASSERT(monitor.poll() == MemoryPressureLevel::Critical, "High PSI is critical pressure");
+    ASSERT(trims == 2 && seen == MemoryPressureLevel::Critical, "Critical pressure trims and notifies");
+
+    // Scratch arenas give their memory back at the next operation boundary
+    // (the polls above already requested a trim, which the first scope honours)
+    ScratchArena& arena = ScratchArena::local();
+    for (int i = 0; i < 2; ++i) {
+        ScratchScope scope;
+        scope.allocateArray<int16_t>(1000);
+    }
+    ASSERT(arena.capacity() > 0, "Arena should retain memory between operations");
+    ScratchArena::requestTrim();
+    {
+        ScratchScope scope;
+        scope.allocateArray<int16_t>(1000);
+    }
+    ASSERT(arena.capacity() == 0, "Arena should release memory after a trim request");
+
+    // Idle workers release theirs when the trim is requested, not after
+    // their next task
+    Scheduler pool(1);
+    auto worker_capacity = [&pool]() {
+        std::promise<size_t> capacity;
+        std::future<size_t> result = capacity.get_future();
+        pool.submit([&capacity]() { capacity.set_value(ScratchArena::local().capacity()); });
+        return result.get();
+    };
+    pool.submit([]() {
+        ScratchScope scope;
+        scope.allocateArray<int16_t>(1000);
+    });
+    ASSERT(worker_capacity() > 0, "Worker arena should retain memory between tasks");
+    ScratchArena::requestTrim();
+    ASSERT(worker_capacity() == 0, "Idle worker should release its arena on a trim request");
+
+    // Background thread polls until stopped
+    monitor.start(std::chrono::milliseconds(10));
+    auto give_up = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (trims < 3 && std::chrono::steady_clock::now() < give_up) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    monitor.stop();
+    ASSERT(trims >= 3, "Background monitor should keep trimming under pressure");
+
+    monitor.unregisterCache(cache_id);
+    monitor.removeListener(listener_id);
+    monitor.setProbe(MemoryPressureMonitor::Probe());
+
+    std::cout << "✓ Memory pressure test passed" << std::endl;
+    return true;
+}
+
+bool test_range_locks() {
+    std::cout << "Testing range-locked concurrent editing..." << std::endl;
+
+    // Conflict rules: overlap matters only when one side is exclusive
+    RangeLockTable table;
+    size_t a = table.tryAcquire(0, 100, RangeLockMode::Shared);
+    size_t b = table.tryAcquire(50, 150, RangeLockMode::Shared);
+    ASSERT(a != 0 && b != 0, "Overlapping shared locks should coexist");
+    ASSERT(table.tryAcquire(90, 95, RangeLockMode::Exclusive) == 0, "Exclusive lock should wait for readers");
+    size_t c = table.tryAcquire(150, 200, RangeLockMode::Exclusive);
+    ASSERT(c != 0, "Disjoint exclusive lock should be granted");
+    table.release(a);
+    table.release(b);
+    table.release(c);
+
+    // Writers on disjoint regions run alongside a structural editor near the end
+    auto track = SoundSegment::create();
+    const size_t region = 20000;
+    track->write(std::vector<int16_t>(region * 5, 0), 0);
+
+    std::vector<std::thread> threads;
+    for (int k = 0; k < 4; ++k) {
+        threads.emplace_back([&track, k, region]() {
+            std::vector<int16_t> chunk(100, static_cast<int16_t>(k + 1));
+            for (int round = 0; round < 50; ++round) {
+                for (size_t pos = k * region; pos < (k + 1) * region; pos += chunk.size()) {
+                    track->write(chunk, pos);
+                }
+            }
+        });
+    }
+    threads.emplace_back([&track, region]() {
+        auto clip = SoundSegment::create();
+        clip->write(std::vector<int16_t>(100, 9), 0);
+        for (int round = 0; round < 200; ++round) {
+            track->insert(*clip, region * 4 + 500, 0, 100);
+            track->deleteRange(region * 4 + 500, 100);
+        }
+    });
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    ASSERT(track->length() == region * 5, "Inserts and deletes should cancel out");
+    auto samples = track->getAllSamples();
+    for (size_t i = 0; i < region * 4; ++i) {
+        ASSERT(samples[i] == static_cast<int16_t>(i / region + 1), "Each writer should own its region");
+    }
+    for (size_t i = region * 4; i < region * 5; ++i) {
+        ASSERT(samples[i] == 0, "Structural edits should leave the tail unchanged");
+    }
+
+    std::cout << "✓ Range lock test passed" << std::endl;
+    return true;
+}
+
+bool test_segment_table() {
+    std::cout << "Testing segment table reads and invalidation..." << std::endl;
+
+    // Fragment a track with many small inserts, mirroring it in a vector
+    auto track = SoundSegment::create();
+    std::vector<int16_t> expected(1000);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        expected[i] = static_cast<int16_t>(i);
+    }
+    track->write(expected, 0);
+
+    auto clip = SoundSegment::create();
+    clip->write(std::vector<int16_t>{-1, -2, -3}, 0);
+    for (size_t k = 0; k < 100; ++k) {
+        size_t pos = (k * 37) % track->length();
+        track->insert(*clip, pos, 0, 3);
+        expected.insert(expected.begin() + pos, {-1, -2, -3});
+    }
+    ASSERT(!track->isIndexed(), "Structural edits should drop the table");
+
+    // The first fragmented read walks the list and leaves a table behind
+    ASSERT(track->getAllSamples() == expected, "List walk should match reference");
+    ASSERT(track->isIndexed(), "A long walk should rebuild the table");
+    ASSERT(track->getAllSamples() == expected, "Table read should match reference");
+
+    std::vector<int16_t> window;
+    track->read(window, 500, 40);
+    ASSERT(std::equal(window.begin(), window.end(), expected.begin() + 500), "Table read at offset should match");
+
+    // In-place writes go through the table and keep it valid
+    track->write(std::vector<int16_t>(10, 7), 295);
+    std::fill(expected.begin() + 295, expected.begin() + 305, 7);
+    ASSERT(track->isIndexed(), "In-place writes should keep the table");
+    ASSERT(track->getAllSamples() == expected, "Writes through the table should land in the segments");
+
+    std::vector<int16_t> scanned;
+    track->scan(100, 900, [&scanned](const int16_t* samples, size_t count) {
+        scanned.insert(scanned.end(), samples, samples + count);
+    });
+    ASSERT(std::equal(scanned.begin(), scanned.end(), expected.begin() + 100) && scanned.size() == 900,
+           "Scan should visit the requested range in order");
+
+    track->deleteRange(10, 50);
+    expected.erase(expected.begin() + 10, expected.begin() + 60);
+    ASSERT(!track->isIndexed(), "Delete should drop the table");
+    track->rebuildIndex();
+    ASSERT(track->getAllSamples() == expected, "Rebuilt table should reflect the delete");
+
+    ASSERT(SegmentTableCache::trimAll() > 0, "Trimming should release the cached table");
+    ASSERT(!track->isIndexed(), "Trimmed track should fall back to the list");
+    ASSERT(track->getAllSamples() == expected, "Reads should still work after a trim");
+
+    // Spans beyond the 32-bit descriptor fields are rejected, not truncated
+    bool rejected = false;
+    try {
+        SegmentNode oversized(SampleBuffer::allocate(1), 0, SEGMENT_MAX_LENGTH + 1);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    ASSERT(rejected, "Oversized segment length should throw");
+    rejected = false;
+    try {
+        SegmentNode far(SampleBuffer::allocate(1), SEGMENT_MAX_LENGTH + 1, 1);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    ASSERT(rejected, "Oversized segment offset should throw");
+
+    // Very long segment lists must tear down without recursing per node
+    const size_t many = 300000;
+    auto strip = SoundSegment::create();
+    strip->write(std::vector<int16_t>(many * 2, 4), 0);
+    {
+        TrackBuilder builder;
+        for (size_t i = 0; i < many; ++i) {
+            builder.append(*strip, i * 2, 1);
+        }
+        auto fragmented = builder.build();
+        ASSERT(fragmented->length() == many, "Fragmented track should hold one sample per clip");
+        auto before_delete = fragmented->snapshot();
+        ASSERT(before_delete->segmentCount() == many, "Every clip should be its own segment");
+
+        // A long detached chain, then a long list replaced by restore
+        ASSERT(fragmented->deleteRange(0, many - 1), "Deleting most of the track should succeed");
+        fragmented->restore(before_delete);
+        ASSERT(fragmented->length() == many, "Restore should bring the segments back");
+    }
+
+    std::cout << "✓ Segment table test passed" << std::endl;
+    return true;
+}
+
+bool test_snapshots() {
+    std::cout << "Testing compact descriptors and snapshots..." << std::endl;
+
+    ASSERT(sizeof(SegmentDescriptor) == 16, "Descriptors should pack into 16 bytes");
+
+    auto track = SoundSegment::create();
+    std::vector<int16_t> original(500);
+    for (size_t i = 0; i < original.size(); ++i) {
+        original[i] = static_cast<int16_t>(i);
+    }
+    track->write(original, 0);
+    auto clip = SoundSegment::create();
+    clip->write(std::vector<int16_t>{-5, -6}, 0);
+    track->insert(*clip, 100, 0, 2);
+    original.insert(original.begin() + 100, {-5, -6});
+
+    auto snap = track->snapshot();
+    ASSERT(snap->totalLength() == original.size(), "Snapshot should cover the whole track");
+    ASSERT(snap->segmentCount() == 3, "Snapshot should record one descriptor per segment");
+
+    // Edits after the snapshot must not show through it
+    track->write(std::vector<int16_t>(10, 99), 95);
+    track->deleteRange(300, 20);
+    track->deleteRange(0, 1);
+    track->insert(*clip, 50, 0, 2);
+
+    std::vector<int16_t> from_snap(snap->totalLength());
+    snap->copyOut(from_snap.data(), 0, from_snap.size());
+    ASSERT(from_snap == original, "Snapshot should keep the samples it was taken with");
+
+    std::vector<int16_t> edited = track->getAllSamples();
+    ASSERT(edited.size() == original.size() - 21 + 2, "Edits should apply to the live track");
+    ASSERT(edited[96] == 99 && edited[105] == 99, "Writes should land in private copies");
+
+    // Restoring shares the snapshot's buffers again; writes still copy first
+    auto copy = SoundSegment::create();
+    copy->restore(snap);
+    ASSERT(copy->getAllSamples() == original, "Restored track should match the snapshot");
+    copy->write(std::vector<int16_t>{1234}, 0);
+    snap->copyOut(from_snap.data(), 0, from_snap.size());
+    ASSERT(from_snap == original, "Writes to a restored track should not modify the snapshot");
+
+    track->restore(snap);
+    ASSERT(track->getAllSamples() == original, "Restore should undo the edits");
+
+    std::cout << "✓ Snapshot test passed" << std::endl;
+    return true;
+}
+
+bool test_inline_buffers() {
+    std::cout << "Testing inline storage for tiny segments..." << std::endl;
+
+    auto tiny = SampleBuffer::allocate(3);
+    ASSERT(tiny->isInline() && tiny->size() == 3, "Tiny buffers should be stored inline");
+    ASSERT(tiny->data()[0] == 0 && tiny->data()[2] == 0, "Inline buffers should be zeroed");
+    auto edge = SampleBuffer::allocate(SAMPLE_BUFFER_INLINE_MAX);
+    ASSERT(edge->isInline(), "Buffers at the threshold should be inline");
+    auto large = SampleBuffer::allocate(SAMPLE_BUFFER_INLINE_MAX + 1);
+    ASSERT(!large->isInline(), "Larger buffers should use separate storage");
+
+    // Sample-level patches produce inline segments that behave like any other
+    auto track = SoundSegment::create();
+    std::vector<int16_t> expected(1000, 1);
+    track->write(expected, 0);
+    auto patch = SoundSegment::create();
+    patch->write(std::vector<int16_t>{7, 8, 9}, 0);
+    for (size_t pos = 100; pos < 900; pos += 100) {
+        track->insert(*patch, pos, 0, 3);
+        expected.insert(expected.begin() + pos, {7, 8, 9});
+    }
+    track->write(std::vector<int16_t>{5, 5}, 201);
+    expected[201] = expected[202] = 5;
+    ASSERT(track->getAllSamples() == expected, "Inline segments should read back correctly");
+
+    size_t inline_buffers = 0;
+    for (const auto& buffer : track->snapshot()->buffers) {
+        inline_buffers += buffer->isInline() ? 1 : 0;
+    }
+    ASSERT(inline_buffers == 8, "Each patch should get an inline buffer");
+
+    std::cout << "✓ Inline buffer test passed" << std::endl;
+    return true;
+}
+
+bool test_piece_table_writes() {
+    std::cout << "Testing piece-table write mode..." << std::endl;
+
+    auto track = SoundSegment::create();
+    std::vector<int16_t> expected(1000);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        expected[i] = static_cast<int16_t>(i);
+    }
+    track->write(expected, 0);
+    auto before = track->snapshot();
+    std::vector<int16_t> original = expected;
+
+    track->setWriteMode(WriteMode::PieceTable);
+    ASSERT(track->writeMode() == WriteMode::PieceTable, "Write mode should be switchable");
+
+    // Sequential writes grow one piece rather than adding a node each
+    for (size_t k = 0; k < 10; ++k) {
+        std::vector<int16_t> chunk(10, static_cast<int16_t>(-1 - k));
+        track->write(chunk, 100 + k * 10);
+        std::copy(chunk.begin(), chunk.end(), expected.begin() + 100 + k * 10);
+    }
+    ASSERT(track->snapshot()->segmentCount() == 3, "Sequential piece writes should coalesce");
+    ASSERT(track->getAllSamples() == expected, "Piece writes should read back");
+
+    // Scattered, overlapping and extending writes against a reference copy
+    unsigned seed = 12345;
+    for (int round = 0; round < 200; ++round) {
+        seed = seed * 1103515245u + 12345u;
+        size_t pos = (seed >> 8) % (expected.size() + 20);
+        size_t len = 1 + (seed >> 20) % 40;
+        std::vector<int16_t> chunk(len, static_cast<int16_t>(round));
+        track->write(chunk, pos);
+        if (pos + len > expected.size()) {
+            expected.resize(pos + len, 0);
+        }
+        std::copy(chunk.begin(), chunk.end(), expected.begin() + pos);
+    }
+    ASSERT(track->getAllSamples() == expected, "Scattered piece writes should match reference");
+
+    // The original buffer was never copied or modified
+    auto after = track->snapshot();
+    ASSERT(after->buffers[0] == before->buffers[0], "Original buffer should still back the track");
+    std::vector<int16_t> from_before(before->totalLength());
+    before->copyOut(from_before.data(), 0, from_before.size());
+    ASSERT(from_before == original, "Snapshot should be unaffected by piece writes");
+
+    std::cout << "✓ Piece-table write test passed" << std::endl;
+    return true;
+}
+
+bool test_block_copy_on_write() {
+    std::cout << "Testing block-granular copy-on-write..." << std::endl;
+
+    auto track = SoundSegment::create();
+    std::vector<int16_t> expected(100000);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        expected[i] = static_cast<int16_t>(i % 1000);
+    }
+    track->write(expected, 0);
+    auto before = track->snapshot();
+
+    // A one-sample patch copies only the block around it
+    track->write(std::vector<int16_t>{-1}, 5000);
+    expected[5000] = -1;
+    auto after = track->snapshot();
+    ASSERT(after->segmentCount() == 3, "Patch should split the shared node around one block");
+    ASSERT(after->starts[1] == 4096 && after->starts[2] == 8192, "Copied region should be block aligned");
+    ASSERT(after->buffers.size() == 2 && after->buffers[1]->size() == COW_BLOCK_SAMPLES,
+           "Only one block should be copied");
+
+    // The copy is shared by the second snapshot now, so the next patch copies again,
+    // but within the same block boundaries
+    track->write(std::vector<int16_t>{-2, -2}, 8191);
+    expected[8191] = expected[8192] = -2;
+    ASSERT(track->getAllSamples() == expected, "Patched track should read back");
+    ASSERT(track->snapshot()->segmentCount() == 4, "Straddling write should copy two blocks");
+
+    // Without a snapshot in between, nearby writes reuse the private block
+    auto fresh = SoundSegment::create();
+    fresh->write(std::vector<int16_t>(20000, 3), 0);
+    fresh->snapshot();
+    fresh->write(std::vector<int16_t>{9}, 100);
+    fresh->write(std::vector<int16_t>{9}, 200);
+    fresh->write(std::vector<int16_t>{9}, 4000);
+    ASSERT(fresh->snapshot()->segmentCount() == 2, "Writes in one copied block should go in place");
+
+    std::vector<int16_t> from_before(before->totalLength());
+    before->copyOut(from_before.data(), 0, from_before.size());
+    ASSERT(from_before[5000] == 0 && from_before[8191] == 191, "Original snapshot should be unchanged");
+
+    std::cout << "✓ Block copy-on-write test passed" << std::endl;
+    return true;
+}
+
+bool test_write_coalescing() {
+    std::cout << "Testing write coalescing..." << std::endl;
+
+    auto track = SoundSegment::create();
+    std::vector<int16_t> expected(50000, 1);
+    track->write(expected, 0);
+    track->setWriteCoalescing(true);
+
+    // Adjacent and overlapping beeps merge into single runs
+    for (size_t pos = 1000; pos < 1100; pos += 10) {
+        track->write(std::vector<int16_t>(10, 2), pos);
+    }
+    track->write(std::vector<int16_t>(30, 3), 1090);
+    track->write(std::vector<int16_t>(5, 4), 30000);
+    std::fill(expected.begin() + 1000, expected.begin() + 1090, 2);
+    std::fill(expected.begin() + 1090, expected.begin() + 1120, 3);
+    std::fill(expected.begin() + 30000, expected.begin() + 30005, 4);
+    ASSERT(track->pendingWrites() == 2, "Touching writes should merge into one run");
+
+    // Reads outside the pending runs leave them buffered
+    std::vector<int16_t> window;
+    track->read(window, 0, 1000);
+    ASSERT(track->pendingWrites() == 2, "Unaffected reads should not flush");
+    track->read(window, 1050, 10);
+    ASSERT(track->pendingWrites() == 0, "Reading a pending range should flush");
+    ASSERT(window == std::vector<int16_t>(10, 2), "Flushed samples should be visible");
+    ASSERT(track->getAllSamples() == expected, "Coalesced writes should match reference");
+
+    // Many scattered writes over a fragmented track, then a structural edit
+    auto clip = SoundSegment::create();
+    clip->write(std::vector<int16_t>{-7}, 0);
+    for (size_t pos = 100; pos < 40000; pos += 400) {
+        track->insert(*clip, pos, 0, 1);
+        expected.insert(expected.begin() + pos, -7);
+    }
+    unsigned seed = 777;
+    for (int k = 0; k < 2000; ++k) {
+        seed = seed * 1103515245u + 12345u;
+        size_t pos = (seed >> 8) % (expected.size() - 16);
+        int16_t value = static_cast<int16_t>(k);
+        track->write(std::vector<int16_t>(1 + k % 16, value), pos);
+        std::fill(expected.begin() + pos, expected.begin() + pos + 1 + k % 16, value);
+    }
+    ASSERT(track->pendingWrites() > 0, "Scattered writes should be buffered");
+    track->deleteRange(0, 10);
+    expected.erase(expected.begin(), expected.begin() + 10);
+    ASSERT(track->pendingWrites() == 0, "Structural edits should flush first");
+    ASSERT(track->getAllSamples() == expected, "Flushed scattered writes should match reference");
+
+    // Extending writes bypass the buffer but stay ordered after it
+    track->write(std::vector<int16_t>(4, 5), 100);
+    track->write(std::vector<int16_t>(8, 6), expected.size() - 2);
+    std::fill(expected.begin() + 100, expected.begin() + 104, 5);
+    expected.resize(expected.size() + 6);
+    std::fill(expected.end() - 8, expected.end(), 6);
+    track->setWriteCoalescing(false);
+    ASSERT(track->getAllSamples() == expected, "Extending writes should apply after buffered ones");
+
+    // A reader racing a flush must still see writes that have returned
+    auto raced = SoundSegment::create();
+    raced->write(std::vector<int16_t>(20000, 0), 0);
+    raced->setWriteMode(WriteMode::PieceTable);
+    raced->setWriteCoalescing(true);
+    std::atomic<int> written(0);
+    std::atomic<bool> writing(true);
+    std::atomic<int> stale(0);
+    std::thread flusher([&]() {
+        while (writing) {
+            raced->flushWrites();
+        }
+    });
+    std::thread reader([&]() {
+        std::vector<int16_t> sample;
+        while (writing) {
+            int expected_at_least = written.load();
+            raced->read(sample, 19500, 1);
+            if (sample[0] < expected_at_least) ++stale;
+        }
+    });
+    for (int k = 1; k <= 30000; ++k) {
+        raced->write(std::vector<int16_t>{static_cast<int16_t>(k)}, 19500);
+        // Earlier runs are applied first, widening the window before this one
+        for (int f = 0; f < 8; ++f) {
+            raced->write(std::vector<int16_t>{1}, 1000 + ((k * 8 + f) % 120) * 150);
+        }
+        written = k;
+    }
+    writing = false;
+    flusher.join();
+    reader.join();
+    ASSERT(stale == 0, "Reads during a flush should see every returned write");
+
+    // Moving a track hands over its buffered writes; the source starts empty
+    SoundSegment source;
+    source.write(std::vector<int16_t>(100, 1), 0);
+    source.setWriteCoalescing(true);
+    source.write(std::vector<int16_t>{2}, 10);
+    SoundSegment moved(std::move(source));
+    ASSERT(moved.pendingWrites() == 1 && source.pendingWrites() == 0, "Move should take the buffered writes");
+    source.write(std::vector<int16_t>(50, 3), 0);
+    source.write(std::vector<int16_t>{4}, 5);
+    ASSERT(moved.pendingWrites() == 1, "Writes through the moved-from track should stay there");
+    SoundSegment assigned;
+    assigned = std::move(moved);
+    ASSERT(assigned.pendingWrites() == 1 && moved.pendingWrites() == 0, "Move assignment should take the buffered writes");
+    std::vector<int16_t> moved_expected(100, 1);
+    moved_expected[10] = 2;
+    ASSERT(assigned.getAllSamples() == moved_expected, "Moved track should flush only its own writes");
+    std::vector<int16_t> source_expected(50, 3);
+    source_expected[5] = 4;
+    ASSERT(source.getAllSamples() == source_expected, "Moved-from track should keep working on its own");
+
+    std::cout << "✓ Write coalescing test passed" << std::endl;
+    return true;
+}
+
+bool test_adopt_buffers() {
+    std::cout << "Testing adoption of caller-owned buffers..." << std::endl;
+
+    auto track = SoundSegment::create();
+    track->write(std::vector<int16_t>(100, 1), 0);
+
+    // A moved-in vector becomes the segment's storage as-is
+    std::vector<int16_t> decoded(50, 2);
+    const int16_t* decoded_data = decoded.data();
+    track->adopt(std::move(decoded), 20);
+    std::vector<int16_t> expected(100, 1);
+    std::fill(expected.begin() + 20, expected.begin() + 70, 2);
+    ASSERT(track->getAllSamples() == expected, "Adopted samples should overwrite the range");
+
+    bool found = false;
+    for (const auto& buffer : track->snapshot()->buffers) {
+        found |= buffer->data() == decoded_data;
+    }
+    ASSERT(found, "Adopted vector should not be copied");
+
+    // External memory is released through the deleter once no segment uses it
+    int released = 0;
+    {
+        auto other = SoundSegment::create();
+        int16_t* external = new int16_t[30];
+        std::fill(external, external + 30, 3);
+        other->adopt(external, 30, [&released](int16_t* p) { delete[] p; ++released; }, 10);
+        std::vector<int16_t> with_gap(40, 0);
+        std::fill(with_gap.begin() + 10, with_gap.end(), 3);
+        ASSERT(other->getAllSamples() == with_gap, "Adopting past the end should leave silence before");
+        other->deleteRange(0, 5);
+        ASSERT(released == 0, "Memory should stay alive while segments use it");
+    }
+    ASSERT(released == 1, "Deleter should run when the track goes away");
+
+    // WAV loading hands the decoded vector over without a second copy
+    track->saveToWav("test_adopt.wav");
+    auto loaded = SoundSegment::create();
+    loaded->loadFromWav("test_adopt.wav");
+    std::remove("test_adopt.wav");
+    ASSERT(loaded->getAllSamples() == expected, "Loaded track should match");
+    ASSERT(loaded->snapshot()->segmentCount() == 1, "Loaded track should be one adopted segment");
+
+    std::cout << "✓ Buffer adoption test passed" << std::endl;
+    return true;
+}
+
+bool test_insert_from_memory() {
+    std::cout << "Testing insert from raw buffers..." << std::endl;
+
+    auto track = SoundSegment::create();
+    track->write(std::vector<int16_t>{1, 2, 3, 4, 5}, 0);
+
+    int16_t clip[] = {10, 20};
+    track->insert(2, clip, 2);
+    clip[0] = 99;  // The pointer variant copies
+    ASSERT(track->getAllSamples() == std::vector<int16_t>({1, 2, 10, 20, 3, 4, 5}), "Raw insert should splice in a copy");
+
+    std::vector<int16_t> decoded = {7, 8, 9};
+    const int16_t* decoded_data = decoded.data();
+    track->insert(0, std::move(decoded));
+    track->insert(100, std::vector<int16_t>{6});
+    ASSERT(track->getAllSamples() == std::vector<int16_t>({7, 8, 9, 1, 2, 10, 20, 3, 4, 5, 6}),
+           "Adopting inserts should splice at the front and append past the end");
+    ASSERT(track->snapshot()->buffers[0]->data() == decoded_data, "Adopted insert should not copy");
+
+    int released = 0;
+    {
+        auto other = SoundSegment::create();
+        other->write(std::vector<int16_t>{1, 1}, 0);
+        int16_t* external = new int16_t[2]{5, 5};
+        other->insert(1, external, 2, [&released](int16_t* p) { delete[] p; ++released; });
+        ASSERT(other->getAllSamples() == std::vector<int16_t>({1, 5, 5, 1}), "External insert should splice in");
+    }
+    ASSERT(released == 1, "External insert should release its memory with the track");
+
+    std::cout << "✓ Insert from memory test passed" << std::endl;
+    return true;
+}
+
+bool test_move_range() {
+    std::cout << "Testing zero-copy range moves..." << std::endl;
+
+    auto src = SoundSegment::create();
+    auto dest = SoundSegment::create();
+    std::vector<int16_t> src_samples(100);
+    for (size_t i = 0; i < src_samples.size(); ++i) {
+        src_samples[i] = static_cast<int16_t>(i);
+    }
+    src->write(src_samples, 0);
+    dest->write(std::vector<int16_t>(10, -1), 0);
+    const int16_t* src_data = src->snapshot()->buffers[0]->data();
+
+    ASSERT(dest->moveRange(*src, 20, 30, 5), "Move between tracks should succeed");
+    ASSERT(src->length() == 70 && dest->length() == 40, "Lengths should transfer");
+
+    std::vector<int16_t> expected_src(src_samples.begin(), src_samples.begin() + 20);
+    expected_src.insert(expected_src.end(), src_samples.begin() + 50, src_samples.end());
+    std::vector<int16_t> expected_dest(5, -1);
+    expected_dest.insert(expected_dest.end(), src_samples.begin() + 20, src_samples.begin() + 50);
+    expected_dest.insert(expected_dest.end(), 5, -1);
+    ASSERT(src->getAllSamples() == expected_src, "Source should lose the range");
+    ASSERT(dest->getAllSamples() == expected_dest, "Destination should gain the range");
+
+    auto dest_table = dest->snapshot();
+    ASSERT(dest_table->buffers[dest_table->segments[1].buffer]->data() == src_data,
+           "Moved segments should keep their buffer");
+
+    ASSERT(!dest->moveRange(*src, 60, 20, 0), "Out-of-range moves should fail");
+    ASSERT(src->length() == 70, "Failed move should leave the source unchanged");
+
+    // Moves within one track, in both directions
+    auto track = SoundSegment::create();
+    track->write(std::vector<int16_t>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}, 0);
+    ASSERT(track->moveRange(*track, 1, 3, 8), "Forward move should succeed");
+    ASSERT(track->getAllSamples() == std::vector<int16_t>({0, 4, 5, 6, 7, 1, 2, 3, 8, 9}), "Forward move");
+    ASSERT(track->moveRange(*track, 7, 3, 0), "Backward move should succeed");
+    ASSERT(track->getAllSamples() == std::vector<int16_t>({3, 8, 9, 0, 4, 5, 6, 7, 1, 2}), "Backward move");
+    ASSERT(!track->moveRange(*track, 2, 4, 3), "Moving a range into itself should fail");
+
+    std::cout << "✓ Move range test passed" << std::endl;
+    return true;
+}
+
+bool test_duplicate_range() {
+    std::cout << "Testing range duplication within a track..." << std::endl;
+
+    auto track = SoundSegment::create();
+    std::vector<int16_t> expected(20000);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        expected[i] = static_cast<int16_t>(i % 3000);
+    }
+    track->write(expected, 0);
+    auto clip = SoundSegment::create();
+    clip->write(std::vector<int16_t>{-9, -9}, 0);
+    track->insert(*clip, 5000, 0, 2);
+    expected.insert(expected.begin() + 5000, {-9, -9});
+    size_t buffers_before = track->snapshot()->buffers.size();
+
+    // Destination inside the source range: the copy is of the original range
+    ASSERT(track->duplicateRange(4000, 2000, 4500), "Overlapping duplicate should succeed");
+    std::vector<int16_t> copy(expected.begin() + 4000, expected.begin() + 6000);
+    expected.insert(expected.begin() + 4500, copy.begin(), copy.end());
+    ASSERT(track->getAllSamples() == expected, "Overlapping duplicate should match reference");
+    ASSERT(track->snapshot()->buffers.size() == buffers_before, "Duplicates should share buffers");
+
+    // Writing one copy must not show through the other
+    track->write(std::vector<int16_t>(10, 555), 4600);
+    std::fill(expected.begin() + 4600, expected.begin() + 4610, 555);
+    ASSERT(track->getAllSamples() == expected, "Shared segments should copy on write");
+    track->deleteRange(100, 50);
+    expected.erase(expected.begin() + 100, expected.begin() + 150);
+    ASSERT(track->getAllSamples() == expected, "Deletes should not move shared samples");
+
+    // Self-insert goes through the same path
+    track->insert(*track, 0, 10, 5);
+    std::vector<int16_t> head_copy(expected.begin() + 10, expected.begin() + 15);
+    expected.insert(expected.begin(), head_copy.begin(), head_copy.end());
+    ASSERT(track->getAllSamples() == expected, "Self-insert should duplicate the range");
+    ASSERT(!track->duplicateRange(expected.size() - 1, 2, 0), "Out-of-range duplicate should fail");
+
+    std::cout << "✓ Duplicate range test passed" << std::endl;
+    return true;
+}
+
+bool test_split_track() {
+    std::cout << "Testing zero-copy track split..." << std::endl;
+
+    auto track = SoundSegment::create();
+    std::vector<int16_t> samples(10000);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = static_cast<int16_t>(i);
+    }
+    track->write(samples, 0);
+    track->insert(3000, std::vector<int16_t>{-1, -1});
+    samples.insert(samples.begin() + 3000, {-1, -1});
+    auto original = track->snapshot();
+
+    std::vector<size_t> cuts = {1000, 3001, 3001, 9000};
+    auto parts = track->split(cuts);
+    ASSERT(parts.size() == 5, "k cuts should give k + 1 parts");
+    ASSERT(parts[2]->length() == 0, "Repeated cut should give an empty part");
+
+    size_t start = 0;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        size_t end = i < cuts.size() ? cuts[i] : samples.size();
+        std::vector<int16_t> expected(samples.begin() + start, samples.begin() + end);
+        ASSERT(parts[i]->getAllSamples() == expected, "Each part should hold its range");
+        for (const auto& buffer : parts[i]->snapshot()->buffers) {
+            bool reused = std::find(original->buffers.begin(), original->buffers.end(), buffer) !=
+                          original->buffers.end();
+            ASSERT(reused, "Parts should reuse the original buffers");
+        }
+        start = end;
+    }
+    ASSERT(track->snapshot()->buffers == original->buffers, "Split should leave the track unchanged");
+    ASSERT(track->getAllSamples() == samples, "Original track should be intact");
+
+    // Parts are independent tracks from here on
+    parts[0]->write(std::vector<int16_t>(10, 42), 0);
+    ASSERT(track->getAllSamples() == samples, "Writing a part should not change the original");
+
+    bool threw = false;
+    try {
+        track->split({500, 100});
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "Unsorted cut points should be rejected");
+
+    // A source with a cached table must still copy before writing shared buffers
+    auto indexed = SoundSegment::create();
+    indexed->write(std::vector<int16_t>(2000, 1), 0);
+    for (size_t i = 0; i < 40; ++i) {
+        indexed->insert(i * 40, std::vector<int16_t>{1});
+    }
+    indexed->rebuildIndex();
+    ASSERT(indexed->isIndexed(), "Source should be indexed before the split");
+    auto halves = indexed->split({500});
+    indexed->write(std::vector<int16_t>{777}, 5);
+    ASSERT(halves[0]->getAllSamples()[5] == 1, "Writing an indexed source should not reach its split parts");
+
+    std::cout << "✓ Split test passed" << std::endl;
+    return true;
+}
+
+bool test_concat_tracks() {
+    std::cout << "Testing concatenation of many tracks..." << std::endl;
+
+    std::vector<std::unique_ptr<SoundSegment>> clips;
+    std::vector<const SoundSegment*> sources;
+    std::vector<int16_t> expected;
+    for (int i = 0; i < 50; ++i) {
+        auto clip = SoundSegment::create();
+        std::vector<int16_t> samples(100 + i, static_cast<int16_t>(i));
+        clip->write(samples, 0);
+        if (i % 3 == 0) {
+            // Fragment some clips so several segments get linked per clip
+            clip->insert(10, std::vector<int16_t>{-1, -2, -3});
+            samples.insert(samples.begin() + 10, {-1, -2, -3});
+        }
+        expected.insert(expected.end(), samples.begin(), samples.end());
+        sources.push_back(clip.get());
+        clips.push_back(std::move(clip));
+    }
+    auto empty = SoundSegment::create();
+    sources.insert(sources.begin() + 5, empty.get());
+
+    auto compilation = SoundSegment::concat(sources);
+    ASSERT(compilation->length() == expected.size(), "Concatenation should sum the lengths");
+    ASSERT(compilation->getAllSamples() == expected, "Clips should appear in order");
+
+    std::vector<int16_t> window(20);
+    compilation->read(window, 95, 20);
+    ASSERT(std::equal(window.begin(), window.end(), expected.begin() + 95), "Reads across clip joins should work");
+
+    // The compilation shares buffers; writing it must not reach the clips
+    compilation->write(std::vector<int16_t>(200, 7), 0);
+    ASSERT(clips[0]->getAllSamples()[0] == 0, "Writing the result should not change a source");
+    clips[1]->write(std::vector<int16_t>(5, 9), 0);
+    ASSERT(compilation->getAllSamples()[200] == expected[200], "Writing a source should not change the result");
+
+    // Builder with sub-ranges, including the same clip twice
+    TrackBuilder builder;
+    builder.append(*clips[2], 10, 20).append(*clips[2], 0, 5).append(*clips[4]);
+    ASSERT(builder.length() == 25 + clips[4]->length(), "Builder should track its length");
+    auto built = builder.build();
+    std::vector<int16_t> part(25);
+    built->read(part, 0, 25);
+    ASSERT(part == std::vector<int16_t>(25, 2), "Sub-ranges should be linked in order");
+    ASSERT(builder.length() == 0, "build should empty the builder");
+
+    bool threw = false;
+    try {
+        builder.append(*clips[2], 100, 50);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "Out-of-range append should throw");
+
+    // An input with a cached table must copy before later writes
+    auto indexed = SoundSegment::create();
+    indexed->write(std::vector<int16_t>(2000, 3), 0);
+    for (size_t i = 0; i < 40; ++i) {
+        indexed->insert(i * 40, std::vector<int16_t>{3});
+    }
+    indexed->rebuildIndex();
+    ASSERT(indexed->isIndexed(), "Input should be indexed before the concat");
+    auto joined = SoundSegment::concat({indexed.get()});
+    indexed->write(std::vector<int16_t>{555}, 5);
+    ASSERT(joined->getAllSamples()[5] == 3, "Writing an indexed input should not reach the concat result");
+
+    std::cout << "✓ Concatenation test passed" << std::endl;
+    return true;
+}
+
+bool test_track_views() {
+    std::cout << "Testing read-only track views..." << std::endl;
+
+    auto track = SoundSegment::create();
+    std::vector<int16_t> samples(20000);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = static_cast<int16_t>(i % 1000);
+    }
+    track->write(samples, 0);
+    for (size_t pos = 1000; pos < 15000; pos += 2000) {
+        track->insert(pos, std::vector<int16_t>{3000, 3001});
+        samples.insert(samples.begin() + pos, {3000, 3001});
+    }
+
+    // Partition the track and read each part from its own thread
+    const size_t parts = 4;
+    size_t part_len = samples.size() / parts;
+    std::vector<std::vector<int16_t>> results(parts);
+    std::vector<std::thread> workers;
+    for (size_t p = 0; p < parts; ++p) {
+        size_t len = p + 1 == parts ? samples.size() - p * part_len : part_len;
+        workers.emplace_back([&, p, len]() {
+            SoundSegmentView part = track->view(p * part_len, len);
+            auto cursor = part.cursor();
+            std::vector<int16_t> chunk(333);
+            while (!cursor.atEnd()) {
+                size_t got = cursor.read(chunk.data(), chunk.size());
+                results[p].insert(results[p].end(), chunk.begin(), chunk.begin() + got);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::vector<int16_t> joined;
+    for (const auto& result : results) {
+        joined.insert(joined.end(), result.begin(), result.end());
+    }
+    ASSERT(joined == samples, "Cursors over a partition should cover the track exactly");
+
+    SoundSegmentView middle = track->view(2990, 3000);
+    ASSERT(middle.length() == 3000 && middle.start() == 2990, "View should record its window");
+    std::vector<int16_t> expected(samples.begin() + 2990, samples.begin() + 5990);
+    ASSERT(middle.getAllSamples() == expected, "View should read its window");
+
+    size_t spanned = 0;
+    bool spans_match = true;
+    middle.scan(5, 100, [&](const int16_t* run, size_t n) {
+        spans_match &= std::equal(run, run + n, expected.begin() + 5 + spanned);
+        spanned += n;
+    });
+    ASSERT(spans_match && spanned == 100, "View spans should match its samples");
+
+    SoundSegmentView inner = middle.view(10, 20);
+    std::vector<int16_t> window;
+    inner.read(window, 0, 50);
+    ASSERT(window.size() == 20, "Reads should stop at the end of the view");
+    ASSERT(std::equal(window.begin(), window.end(), expected.begin() + 10), "Nested view should be relative");
+
+    // Views are live: they see later writes to the parent
+    track->write(std::vector<int16_t>{-5, -6}, 3000);
+    ASSERT(middle.getAllSamples()[10] == -5, "View should see parent writes");
+
+    // identify searches only the window and reports view-relative positions
+    auto ad = SoundSegment::create();
+    ad->write(std::vector<int16_t>{3000, 3001, 3000, -3000}, 0);
+    auto probe = SoundSegment::create();
+    probe->write(std::vector<int16_t>(200, 0), 0);
+    probe->write(std::vector<int16_t>{3000, 3001, 3000, -3000}, 50);
+    probe->write(std::vector<int16_t>{3000, 3001, 3000, -3000}, 150);
+    ASSERT(probe->view(100, 100).identify(*ad) == "50,53", "View identify should be relative to the view");
+    ASSERT(probe->identify(*ad) == "50,53\n150,153", "Track identify should be unchanged");
+
+    bool threw = false;
+    try {
+        track->view(samples.size() - 10, 20);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "View past the end should throw");
+
+    std::cout << "✓ View test passed" << std::endl;
+    return true;
+}
+
+bool test_timeline_ripple() {
+    std::cout << "Testing timeline ripple edits..." << std::endl;
+
+    auto voice = SoundSegment::create();
+    auto music = SoundSegment::create();
+    auto ads = SoundSegment::create();
+    std::vector<int16_t> voice_samples(1000), music_samples(1200), ad_samples(300, 9);
+    for (size_t i = 0; i < voice_samples.size(); ++i) voice_samples[i] = static_cast<int16_t>(i);
+    for (size_t i = 0; i < music_samples.size(); ++i) music_samples[i] = static_cast<int16_t>(-static_cast<int>(i));
+    voice->write(voice_samples, 0);
+    music->write(music_samples, 0);
+    ads->write(ad_samples, 0);
+
+    Timeline timeline;
+    timeline.addTrack(*voice);
+    timeline.addTrack(*music);
+    timeline.addTrack(*ads);
+    ASSERT(timeline.trackCount() == 3 && timeline.length() == 1200, "Timeline should span its longest track");
+
+    bool threw = false;
+    try {
+        timeline.addTrack(*voice);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "A track should only be added once");
+
+    // Delete crosses the end of the ads track and misses nothing else
+    timeline.rippleDelete(200, 150);
+    voice_samples.erase(voice_samples.begin() + 200, voice_samples.begin() + 350);
+    music_samples.erase(music_samples.begin() + 200, music_samples.begin() + 350);
+    ad_samples.resize(200);
+    ASSERT(voice->getAllSamples() == voice_samples, "Voice should ripple");
+    ASSERT(music->getAllSamples() == music_samples, "Music should ripple");
+    ASSERT(ads->getAllSamples() == ad_samples, "Ads should lose only what they had");
+
+    // A gap leaves the short ads track alone
+    timeline.rippleInsert(500, 100);
+    voice_samples.insert(voice_samples.begin() + 500, 100, 0);
+    music_samples.insert(music_samples.begin() + 500, 100, 0);
+    ASSERT(voice->getAllSamples() == voice_samples, "Gap should open in voice");
+    ASSERT(music->getAllSamples() == music_samples, "Gap should open in music");
+    ASSERT(ads->length() == 200, "Tracks ending before the gap should not change");
+
+    // Writing into a shared gap must not leak into other tracks
+    voice->write(std::vector<int16_t>(10, 77), 550);
+    voice_samples[550] = 77;
+    ASSERT(music->getAllSamples() == music_samples, "Gap buffers should copy on write");
+
+    // A clip into one track with matching gaps elsewhere keeps them in sync
+    auto sting = SoundSegment::create();
+    sting->write(std::vector<int16_t>(40, 5), 0);
+    timeline.rippleInsert(100, 1, *sting);
+    voice_samples.insert(voice_samples.begin() + 100, 40, 0);
+    music_samples.insert(music_samples.begin() + 100, 40, 5);
+    ad_samples.insert(ad_samples.begin() + 100, 40, 0);
+    ASSERT(music->getAllSamples() == music_samples, "Clip should land in the target track");
+    ASSERT(ads->getAllSamples() == ad_samples, "Other tracks should get a gap");
+    std::vector<int16_t> voice_now = voice->getAllSamples();
+    ASSERT(voice_now[100] == 0 && voice_now[590] == 77, "Voice should shift with the clip");
+    ASSERT(sting->getAllSamples() == std::vector<int16_t>(40, 5), "Clip should be unchanged");
+
+    // A clip with a cached table must copy before later writes
+    auto jingle = SoundSegment::create();
+    jingle->write(std::vector<int16_t>(2000, 6), 0);
+    for (size_t i = 0; i < 40; ++i) {
+        jingle->insert(i * 40, std::vector<int16_t>{6});
+    }
+    jingle->rebuildIndex();
+    ASSERT(jingle->isIndexed(), "Clip should be indexed before the ripple insert");
+    timeline.rippleInsert(0, 1, *jingle);
+    jingle->write(std::vector<int16_t>{777}, 5);
+    ASSERT(music->getAllSamples()[5] == 6, "Writing an indexed clip should not reach the timeline");
+    timeline.rippleDelete(0, 2040);
+
+    // A clip past the end of a short target still lands at pos
+    {
+        auto short_target = SoundSegment::create();
+        short_target->write(std::vector<int16_t>(4, 2), 0);
+        auto long_member = SoundSegment::create();
+        long_member->write(std::vector<int16_t>(10, 1), 0);
+        Timeline padded;
+        padded.addTrack(*short_target);
+        padded.addTrack(*long_member);
+        auto pair = SoundSegment::create();
+        pair->write(std::vector<int16_t>{9, 9}, 0);
+        padded.rippleInsert(6, 0, *pair);
+        ASSERT(short_target->getAllSamples() == std::vector<int16_t>({2, 2, 2, 2, 0, 0, 9, 9}),
+               "Short target should be padded so the clip lands at pos");
+        ASSERT(long_member->getAllSamples() == std::vector<int16_t>({1, 1, 1, 1, 1, 1, 0, 0, 1, 1, 1, 1}),
+               "Other members should get their gap at the same pos");
+    }
+
+    // Ripple edits and reads from other threads must not interfere
+    std::atomic<bool> stop(false);
+    std::thread reader([&]() {
+        std::vector<int16_t> dest;
+        while (!stop) {
+            music->read(dest, 0, 300);
+            voice->read(dest, 100, 50);
+        }
+    });
+    for (int i = 0; i < 50; ++i) {
+        timeline.rippleInsert(10, 20);
+        timeline.rippleDelete(10, 20);
+    }
+    stop = true;
+    reader.join();
+    ASSERT(music->getAllSamples() == music_samples, "Balanced edits should restore the track");
+
+    timeline.removeTrack(2);
+    ASSERT(timeline.trackCount() == 2, "Track should be removed");
+
+    std::cout << "✓ Timeline test passed" << std::endl;
+    return true;
+}
+
+bool test_edit_stable_markers() {
+    std::cout << "Testing markers that follow edits..." << std::endl;
+
+    auto track = SoundSegment::create();
+    track->write(std::vector<int16_t>(10000, 1), 0);
+    MarkerIndex& markers = track->markers();
+
+    MarkerId chapter = markers.add(5000, 0, "chapter 2");
+    MarkerId ad_slot = markers.add(2000, 500, "ad");
+    MarkerId redact = markers.add(7000, 1000, "redact");
+
+    track->insert(1000, std::vector<int16_t>(100, 2));
+    ASSERT(markers.get(chapter)->start == 5100, "Insert should shift later markers");
+    ASSERT(markers.get(ad_slot)->start == 2100, "Insert should shift later regions");
+
+    track->insert(2300, std::vector<int16_t>(50, 2));
+    ASSERT(markers.get(ad_slot)->length == 550, "Insert inside a region should grow it");
+
+    track->deleteRange(7150, 50);
+    auto cut = markers.get(redact);
+    ASSERT(cut->start == 7150 && cut->length == 950, "Delete at a region's start should trim it");
+
+    track->deleteRange(0, 500);
+    ASSERT(markers.get(chapter)->start == 4650, "Delete before should shift back");
+
+    // Deleting everything a region covers drops it; positions inside collapse
+    MarkerId doomed = markers.add(100, 50, "doomed");
+    MarkerId point = markers.add(120, 0, "point");
+    track->deleteRange(90, 100);
+    ASSERT(!markers.get(doomed), "Fully deleted region should be dropped");
+    ASSERT(markers.get(point)->start == 90, "Position inside a delete should move to its start");
+
+    auto hits = markers.query(1500, 500);
+    ASSERT(hits.size() == 1 && hits[0].label == "ad", "Query should find overlapping regions");
+    ASSERT(markers.query(4550, 1).size() == 1, "Query should find positions");
+    ASSERT(markers.remove(point) && !markers.remove(point), "Remove should work once");
+
+    // Moves and other structural edits keep markers in step too
+    track->moveRange(*track, 0, 10, 100);
+    ASSERT(markers.get(chapter)->start == 4550, "Move before a marker should leave it in place");
+
+    // Compare against a brute-force model over random edits
+    MarkerIndex index;
+    std::vector<Marker> model;
+    uint32_t seed = 12345;
+    auto next = [&seed](uint32_t range) {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 8) % range;
+    };
+    for (int i = 0; i < 300; ++i) {
+        size_t start = next(5000);
+        size_t length = next(3) == 0 ? 0 : next(300);
+        model.push_back(Marker{index.add(start, length), start, length, ""});
+    }
+    for (int step = 0; step < 400; ++step) {
+        size_t pos = next(5000);
+        size_t len = 1 + next(200);
+        if (next(2) == 0) {
+            index.onInsert(pos, len);
+            for (auto& m : model) {
+                if (m.start >= pos) m.start += len;
+                else if (m.length > 0 && m.end() > pos) m.length += len;
+            }
+        } else {
+            index.onDelete(pos, len);
+            std::vector<Marker> kept;
+            for (auto m : model) {
+                size_t end = m.end();
+                if (m.start >= pos + len) {
+                    m.start -= len;
+                } else if (m.start >= pos) {
+                    bool region = m.length > 0;
+                    m.start = pos;
+                    m.length = end > pos + len ? end - pos - len : 0;
+                    if (region && m.length == 0) continue;
+                } else if (m.length > 0 && end > pos) {
+                    m.length -= std::min(end, pos + len) - pos;
+                }
+                kept.push_back(m);
+            }
+            model = kept;
+        }
+    }
+    ASSERT(index.size() == model.size(), "Index should drop the same regions as the model");
+    bool same = true;
+    for (const auto& m : model) {
+        auto got = index.get(m.id);
+        same &= got && got->start == m.start && got->length == m.length;
+    }
+    ASSERT(same, "Index should match the model after random edits");
+
+    size_t q_start = 1000, q_len = 700;
+    size_t expected_hits = 0;
+    for (const auto& m : model) {
+        size_t reach = m.start + std::max<size_t>(m.length, 1);
+        if (m.start < q_start + q_len && reach > q_start) ++expected_hits;
+    }
+    auto found = index.query(q_start, q_len);
+    ASSERT(found.size() == expected_hits, "Range query should match the model");
+    ASSERT(std::is_sorted(found.begin(), found.end(),
+                          [](const Marker& a, const Marker& b) { return a.start < b.start; }),
+           "Query results should be in start order");
+
+    // Restoring a snapshot puts the markers back with the audio
+    auto undoable = SoundSegment::create();
+    undoable->write(std::vector<int16_t>(200, 1), 0);
+    MarkerId cue = undoable->markers().add(80, 0, "cue");
+    MarkerId span = undoable->markers().add(20, 60, "span");
+    auto before_cut = undoable->snapshot();
+    undoable->deleteRange(0, 50);
+    MarkerId added_later = undoable->markers().add(10, 0, "later");
+    ASSERT(undoable->markers().get(cue)->start == 30, "Delete should shift the cue");
+    undoable->restore(before_cut);
+    ASSERT(undoable->markers().get(cue)->start == 80, "Restore should put the cue back");
+    ASSERT(undoable->markers().get(span)->start == 20 && undoable->markers().get(span)->length == 60,
+           "Restore should put the region back");
+    ASSERT(!undoable->markers().get(added_later) && undoable->markers().size() == 2,
+           "Markers added after the snapshot should be gone");
+    ASSERT(undoable->markers().add(0) > added_later, "Ids should not be reused after a restore");
+
+    // Markers travel with a moved track; the source starts with none
+    SoundSegment source;
+    source.write(std::vector<int16_t>(100, 1), 0);
+    MarkerId intro = source.markers().add(40, 0, "intro");
+    SoundSegment moved(std::move(source));
+    ASSERT(moved.markers().get(intro) && source.markers().size() == 0, "Move should take the markers");
+    source.write(std::vector<int16_t>(10, 2), 0);
+    source.markers().add(5, 0, "stray");
+    source.insert(0, std::vector<int16_t>(10, 3));
+    ASSERT(moved.markers().size() == 1 && moved.markers().get(intro)->start == 40,
+           "Edits through the moved-from track should not touch the moved markers");
+    SoundSegment assigned;
+    assigned = std::move(moved);
+    ASSERT(assigned.markers().get(intro) && moved.markers().size() == 0, "Move assignment should take the markers");
+
+    std::cout << "✓ Marker test passed" << std::endl;
+    return true;
+}
+
+bool test_decimated_reads() {
+    std::cout << "Testing decimated preview reads..." << std::endl;
+
+    auto track = SoundSegment::create();
+    std::vector<int16_t> samples(50000);
+    uint32_t seed = 777;
+    for (auto& sample : samples) {
+        seed = seed * 1103515245u + 12345u;
+        sample = static_cast<int16_t>(seed >> 16);
+    }
+    track->write(samples, 0);
+    // Fragment the track so groups straddle segment boundaries
+    for (size_t pos = 777; pos < 45000; pos += 3001) {
+        track->insert(pos, std::vector<int16_t>{32767, -32768, 5});
+        samples.insert(samples.begin() + pos, {32767, -32768, 5});
+    }
+
+    const size_t start = 123;
+    const size_t len = 40000;
+    const DecimateMode modes[] = {DecimateMode::Pick, DecimateMode::Average, DecimateMode::MinMax};
+    for (size_t factor : {1u, 3u, 64u, 1000u, 4099u}) {
+        for (DecimateMode mode : modes) {
+            std::vector<int16_t> expected;
+            for (size_t g = start; g < start + len; g += factor) {
+                size_t end = std::min(g + factor, start + len);
+                if (mode == DecimateMode::Pick) {
+                    expected.push_back(samples[g]);
+                } else if (mode == DecimateMode::Average) {
+                    double total = 0;
+                    for (size_t i = g; i < end; ++i) total += samples[i];
+                    expected.push_back(static_cast<int16_t>(std::lround(total / (end - g))));
+                } else {
+                    auto range = std::minmax_element(samples.begin() + g, samples.begin() + end);
+                    expected.push_back(*range.first);
+                    expected.push_back(*range.second);
+                }
+            }
+            std::vector<int16_t> got;
+            track->readDecimated(got, start, len, factor, mode);
+            ASSERT(got == expected, "Decimated read should match the full-rate reduction");
+        }
+    }
+
+    std::vector<int16_t> tail;
+    track->readDecimated(tail, samples.size() - 10, 100, 4, DecimateMode::MinMax);
+    ASSERT(tail.size() == 6, "Reads past the end should reduce only existing samples");
+
+    bool threw = false;
+    try {
+        track->readDecimated(tail, 0, 100, 0, DecimateMode::Pick);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "Zero factor should be rejected");
+
+    std::cout << "✓ Decimated read test passed" << std::endl;
+    return true;
+}
+
+bool test_converted_reads() {
+    std::cout << "Testing reads with format conversion..." << std::endl;
+
+    auto track = SoundSegment::create();
+    std::vector<int16_t> samples(5003);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = static_cast<int16_t>((i * 7919) % 65536 - 32768);
+    }
+    track->write(samples, 0);
+    track->insert(1001, std::vector<int16_t>{-32768, 32767, 0});
+    samples.insert(samples.begin() + 1001, {-32768, 32767, 0});
+
+    std::vector<float> as_float;
+    track->read(as_float, 990, 3000);
+    ASSERT(as_float.size() == 3000, "Float read should return the requested samples");
+    bool float_ok = true;
+    for (size_t i = 0; i < as_float.size(); ++i) {
+        float_ok &= as_float[i] == samples[990 + i] / 32768.0f;
+    }
+    ASSERT(float_ok, "Float read should normalise to [-1, 1)");
+
+    std::vector<int32_t> as_int;
+    track->read(as_int, 0, samples.size() + 100);
+    ASSERT(as_int.size() == samples.size(), "int32 read should stop at the end of the track");
+    bool int_ok = true;
+    for (size_t i = 0; i < as_int.size(); ++i) {
+        int_ok &= as_int[i] == static_cast<int32_t>(samples[i]) * 65536;
+    }
+    ASSERT(int_ok, "int32 read should scale to full range");
+
+    // Two tracks into one interleaved stereo buffer, with custom scale
+    auto right = SoundSegment::create();
+    right->write(std::vector<int16_t>(100, 1000), 0);
+    std::vector<float> stereo(200, -9.0f);
+    track->read(stereo.data(), 0, 100, 2.0f, 2);
+    right->read(stereo.data() + 1, 0, 100, 0.5f, 2);
+    bool stereo_ok = true;
+    for (size_t i = 0; i < 100; ++i) {
+        stereo_ok &= stereo[2 * i] == samples[i] * 2.0f && stereo[2 * i + 1] == 500.0f;
+    }
+    ASSERT(stereo_ok, "Strided reads should interleave channels");
+
+    std::vector<int32_t> interleaved(60, 0);
+    track->read(interleaved.data() + 2, 1000, 20, 0, 3);
+    bool strided_int = true;
+    for (size_t i = 0; i < 20; ++i) {
+        strided_int &= interleaved[2 + 3 * i] == samples[1000 + i] && interleaved[3 * i] == 0;
+    }
+    ASSERT(strided_int, "Strided int32 reads should leave other channels alone");
+
+    bool threw = false;
+    try {
+        track->read(interleaved.data(), 0, 10, 17);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "Out-of-range shift should be rejected");
+
+    std::cout << "✓ Converted read test passed" << std::endl;
+    return true;
+}
+
+bool test_stft_frames_and_spectrogram() {
+    std::cout << "Testing STFT frames and spectrogram..." << std::endl;
+
+    auto track = SoundSegment::create();
+    std::vector<int16_t> samples(4000);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = static_cast<int16_t>(8000.0 * std::sin(2.0 * M_PI * 1000.0 * i / SAMPLE_RATE) +
+                                          (static_cast<int>(i * 37) % 200) - 100);
+    }
+    track->write(samples, 0);
+    track->insert(1234, std::vector<int16_t>(10, 300));
+    samples.insert(samples.begin() + 1234, 10, 300);
+
+    StftConfig config;  // 200-sample frames, 80-sample hop, 256-point FFT
+    ASSERT(config.resolvedFftSize() == 256, "FFT size should round up to a power of two");
+
+    size_t borrowed = 0;
+    size_t frame_count = 0;
+    {
+        StftFrames frames(*track, 0, samples.size(), config);
+        ASSERT(frames.frameCount() == StftFrames::frameCount(samples.size(), config), "Frame count should be consistent");
+        ASSERT((frames.frameCount() - 1) * config.hop + config.frame_length >= samples.size(),
+               "Frames should cover every sample");
+
+        StftFrames::Frame f;
+        bool frames_ok = true;
+        while (frames.next(f)) {
+            for (size_t i = 0; i < config.frame_length; ++i) {
+                size_t pos = f.start + i;
+                int16_t expected = pos < samples.size() ? samples[pos] : 0;
+                frames_ok &= f.samples[i] == expected;
+            }
+            borrowed += f.borrowed ? 1 : 0;
+            ++frame_count;
+        }
+        ASSERT(frames_ok, "Frames should hold the track's samples, zero-padded at the end");
+        ASSERT(frame_count == frames.frameCount(), "Iterator should visit every frame");
+        ASSERT(borrowed > 0 && borrowed < frame_count, "Frames inside one segment should be borrowed");
+    }
+
+    // Spectrogram against a direct DFT of the windowed frames
+    std::vector<float> spec;
+    size_t rows = Spectrogram::compute(*track, 0, samples.size(), config, spec);
+    size_t bins = Spectrogram::bins(config);
+    ASSERT(rows == frame_count && spec.size() == rows * bins, "Spectrogram should be frames x bins");
+
+    std::vector<float> window = StftFrames::makeWindow(config.window, config.frame_length);
+    bool spectrum_ok = true;
+    for (size_t k : {size_t(0), size_t(7), rows - 1}) {
+        for (size_t bin : {size_t(0), size_t(32), size_t(50), bins - 1}) {
+            double re = 0, im = 0;
+            for (size_t i = 0; i < config.frame_length; ++i) {
+                size_t pos = k * config.hop + i;
+                double x = pos < samples.size() ? samples[pos] / 32768.0 * window[i] : 0.0;
+                re += x * std::cos(2.0 * M_PI * bin * i / 256.0);
+                im -= x * std::sin(2.0 * M_PI * bin * i / 256.0);
+            }
+            double power = re * re + im * im;
+            spectrum_ok &= std::fabs(spec[k * bins + bin] - power) <= 1e-3 * std::max(1.0, power);
+        }
+    }
+    ASSERT(spectrum_ok, "FFT power should match a direct DFT");
+
+    // 1 kHz at 8 kHz with a 256-point FFT peaks at bin 32
+    auto peak = std::max_element(spec.begin() + 7 * bins, spec.begin() + 8 * bins) - (spec.begin() + 7 * bins);
+    ASSERT(peak == 32, "Tone should peak in its bin");
+
+    // Results do not depend on how frames are spread over threads
+    Scheduler single(1);
+    StftConfig small_tasks = config;
+    small_tasks.frames_per_task = 3;
+    std::vector<float> serial(spec.size());
+    Spectrogram::compute(*track, 0, samples.size(), small_tasks, serial.data(), single);
+    ASSERT(serial == spec, "Spectrogram should not depend on task layout");
+
+    // Block scratch comes from the worker's arena: once warm, further
+    // passes do not allocate (run from a task so every block uses one thread)
+    std::promise<bool> steady;
+    std::future<bool> steady_result = steady.get_future();
+    single.submit([&]() {
+        Spectrogram::BlockVisitor ignore = [](size_t, size_t, const float*) {};
+        Spectrogram::forEachBlock(*track, 0, samples.size(), small_tasks, ignore, single);
+        size_t warm = ScratchArena::local().blockAllocations();
+        Spectrogram::forEachBlock(*track, 0, samples.size(), small_tasks, ignore, single);
+        steady.set_value(warm > 0 && ScratchArena::local().blockAllocations() == warm);
+    });
+    ASSERT(steady_result.get(), "Spectrogram blocks should reuse the worker's scratch arena");
+
+    std::cout << "✓ STFT test passed" << std::endl;
+    return true;
+}
+
+bool test_mel_features() {
+    std::cout << "Testing log-mel and MFCC extraction..." << std::endl;
+
+    ASSERT(std::fabs(MelFilterBank::hzToMel(1000.0) - 1000.0) < 0.5, "1 kHz should be about 1000 mel");
+    ASSERT(std::fabs(MelFilterBank::melToHz(MelFilterBank::hzToMel(3210.0)) - 3210.0) < 1e-6, "Mel scale should invert");
+
+    auto make_tone = [](double hz, size_t len) {
+        auto track = SoundSegment::create();
+        std::vector<int16_t> samples(len);
+        for (size_t i = 0; i < len; ++i) {
+            samples[i] = static_cast<int16_t>(6000.0 * std::sin(2.0 * M_PI * hz * i / SAMPLE_RATE));
+        }
+        track->write(samples, 0);
+        return track;
+    };
+    auto low = make_tone(300.0, 6000);
+    auto high = make_tone(2500.0, 4500);
+    low->insert(2000, std::vector<int16_t>(5, 0));
+
+    MelConfig config;
+    auto bank = MelFilterBank::get(config.sample_rate, config.stft.resolvedFftSize(), config.mel_bands,
+                                   config.low_hz, config.high_hz);
+    ASSERT(bank == MelFilterBank::get(config.sample_rate, 256, 40, config.low_hz, config.high_hz),
+           "Filter banks should be cached");
+    ASSERT(bank->bandCount() == 40 && bank->binCount() == 129, "Bank should match the FFT");
+
+    // Log-mel should equal filtering the spectrogram by hand
+    std::vector<float> spec;
+    size_t frames = Spectrogram::compute(*low, 0, low->length(), config.stft, spec);
+    std::vector<float> log_mel;
+    ASSERT(MelFeatures::logMel(*low, 0, low->length(), config, log_mel) == frames, "Log-mel should have one row per frame");
+    ASSERT(log_mel.size() == frames * 40, "Log-mel should be frames x bands");
+
+    std::vector<float> mel(40);
+    bool mel_ok = true;
+    for (size_t f = 0; f < frames; ++f) {
+        bank->apply(spec.data() + f * 129, mel.data());
+        for (size_t b = 0; b < 40; ++b) {
+            float expected = std::log(std::max(mel[b], config.log_floor));
+            mel_ok &= std::fabs(log_mel[f * 40 + b] - expected) < 1e-4f;
+        }
+    }
+    ASSERT(mel_ok, "Log-mel should match the filtered spectrogram");
+
+    // The loudest band follows the tone
+    auto loudest = [](const std::vector<float>& rows, size_t row) {
+        return std::max_element(rows.begin() + row * 40, rows.begin() + (row + 1) * 40) - (rows.begin() + row * 40);
+    };
+    std::vector<float> high_mel;
+    MelFeatures::logMel(*high, 0, high->length(), config, high_mel);
+    ASSERT(loudest(high_mel, 10) > loudest(log_mel, 10), "A higher tone should peak in a higher band");
+
+    // MFCCs are the orthonormal DCT of the log-mel rows
+    std::vector<float> coeffs;
+    MelFeatures::mfcc(*low, 0, low->length(), config, coeffs);
+    ASSERT(coeffs.size() == frames * 13, "MFCCs should be frames x coefficients");
+    std::vector<float> dct = MelFeatures::dctMatrix(13, 40);
+    bool mfcc_ok = true;
+    for (size_t f = 0; f < frames; f += 7) {
+        for (size_t i = 0; i < 13; ++i) {
+            double sum = 0;
+            for (size_t m = 0; m < 40; ++m) {
+                double scale = std::sqrt((i == 0 ? 1.0 : 2.0) / 40.0);
+                sum += log_mel[f * 40 + m] * scale * std::cos(M_PI * i * (m + 0.5) / 40.0);
+            }
+            mfcc_ok &= std::fabs(coeffs[f * 13 + i] - sum) < 1e-3 * std::max(1.0, std::fabs(sum));
+        }
+    }
+    ASSERT(mfcc_ok, "MFCCs should match a direct DCT");
+
+    // Per-block log-mel rows come from the worker's arena: a warm second
+    // pass allocates nothing there (run from a task so one thread does it all)
+    Scheduler single(1);
+    std::promise<bool> steady;
+    std::future<bool> steady_result = steady.get_future();
+    single.submit([&]() {
+        std::vector<float> again(coeffs.size());
+        MelFeatures::mfcc(*low, 0, low->length(), config, again.data(), single);
+        size_t warm = ScratchArena::local().blockAllocations();
+        MelFeatures::mfcc(*low, 0, low->length(), config, again.data(), single);
+        steady.set_value(warm > 0 && ScratchArena::local().blockAllocations() == warm && again == coeffs);
+    });
+    ASSERT(steady_result.get(), "MFCC blocks should reuse the worker's scratch arena");
+
+    // Batch output stacks each track's rows
+    std::vector<float> batch;
+    std::vector<size_t> offsets;
+    size_t rows = MelFeatures::mfccBatch({low.get(), high.get()}, config, batch, offsets);
+    std::vector<float> high_coeffs;
+    size_t high_frames = MelFeatures::mfcc(*high, 0, high->length(), config, high_coeffs);
+    ASSERT(offsets.size() == 3 && offsets[1] == frames && rows == frames + high_frames, "Offsets should delimit tracks");
+    ASSERT(std::equal(coeffs.begin(), coeffs.end(), batch.begin()), "First track's rows should match");
+    ASSERT(std::equal(high_coeffs.begin(), high_coeffs.end(), batch.begin() + offsets[1] * 13),
+           "Second track's rows should match");
+
+    bool threw = false;
+    try {
+        MelConfig bad = config;
+        bad.coefficients = 41;
+        MelFeatures::mfcc(*low, 0, 100, bad, coeffs);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    ASSERT(threw, "More coefficients than bands should be rejected");
+
+    std::cout << "✓ Mel feature test passed" << std::endl;
+    return true;
+}
+
 int main() {
     std::cout << "C++ Audio Editor Test Suite" << std::endl;
     std::cout << "===========================" << std::endl;
@@ -217,6 +1930,30 @@ int main() {
     all_passed &= test_identify_ads();
     all_passed &= test_wav_io();
     all_passed &= test_edge_cases();
+    all_passed &= test_operation_control();
+    all_passed &= test_scratch_arena();
+    all_passed &= test_numa_placement();
+    all_passed &= test_memory_pressure();
+    all_passed &= test_range_locks();
+    all_passed &= test_segment_table();
+    all_passed &= test_snapshots();
+    all_passed &= test_inline_buffers();
+    all_passed &= test_piece_table_writes();
+    all_passed &= test_block_copy_on_write();
+    all_passed &= test_write_coalescing();
+    all_passed &= test_adopt_buffers();
+    all_passed &= test_insert_from_memory();
+    all_passed &= test_move_range();
+    all_passed &= test_duplicate_range();
+    all_passed &= test_split_track();
+    all_passed &= test_concat_tracks();
+    all_passed &= test_track_views();
+    all_passed &= test_timeline_ripple();
+    all_passed &= test_edit_stable_markers();
+    all_passed &= test_decimated_reads();
+    all_passed &= test_converted_reads();
+    all_passed &= test_stft_frames_and_spectrogram();
+    all_passed &= test_mel_features();
     
     std::cout << std::endl;
     if (all_passed) {